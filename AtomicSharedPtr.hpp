@@ -0,0 +1,152 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 可以被多个线程同时 load/store 的 SharedPtr，用于无锁地发布共享对象
+/*
+ * 1. SharedPtr 有两个指针 (ptr_, cb_)，无法放进一个原子字，所以把它装进一个堆上的 box，原子字只存 box 的地址
+ * 2. 原子字的高 16 位是"本地计数"：读者先 fetch_add 本地计数借用 box，复制出 SharedPtr 后再归还
+ * 3. 写者换下旧 box 时，把尚未归还的本地计数转移到 box 自己的计数上，最后一个归还者负责释放 box
+ * 4. box 在任何读者归还之前都不会被释放，所以比较 box 地址不存在 ABA 问题
+ * 5. 只有 load 不分配内存；store/exchange/compare_exchange 要 new 新的 box、delete 旧的 box，
+ *    分配器可能加锁，所以 is_lock_free() 为 false (与 std::atomic<std::shared_ptr> 的常见实现一致)
+ */
+#ifndef ATOMIC_SHARED_PTR_HPP
+#define ATOMIC_SHARED_PTR_HPP
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include "SmartPtr.hpp"
+
+template<class T>
+struct AtomicSharedPtr {
+private:
+    struct Box {
+        SharedPtr<T> value;
+        std::atomic<long> refs{0}; // 已经转移过来、尚未归还的借用数 (可能暂时为负)
+        explicit Box(SharedPtr<T> &&v)noexcept:value(std::move(v)) {}
+    };
+
+    static_assert(sizeof(void *) == 8,"packed pointer needs 64-bit pointers");
+    // 本地计数只有 16 位，同一时刻最多 65535 个还没归还的 load()，再多计数会回绕到 0
+    static constexpr int kShift = 48;
+    static constexpr std::uint64_t kLocal = std::uint64_t(1) << kShift;
+    static constexpr std::uint64_t kPtrMask = kLocal - 1;
+
+    mutable std::atomic<std::uint64_t> word_; // load 也要修改本地计数
+
+    static Box *boxOf(std::uint64_t w)noexcept {
+        return reinterpret_cast<Box *>(static_cast<std::uintptr_t>(w & kPtrMask));
+    }
+    static std::uint64_t pack(Box *box)noexcept {
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(box));
+    }
+    static Box *makeBox(SharedPtr<T> &&value) {
+        return value.get() == nullptr && value.use_count() == 0 ? nullptr : new Box(std::move(value));
+    }
+
+    // 借用当前的 box，返回借用时的原子字
+    std::uint64_t acquire()const noexcept {
+        return word_.fetch_add(kLocal,std::memory_order_acquire);
+    }
+    // 归还借用：box 还挂在原子字上就直接减本地计数，否则它的计数已经转移到 box->refs
+    void release(Box *box)const noexcept {
+        std::uint64_t cur = word_.load(std::memory_order_relaxed);
+        while(boxOf(cur) == box) {
+            if(word_.compare_exchange_weak(cur,cur - kLocal,std::memory_order_release,std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        if(box != nullptr && box->refs.fetch_sub(1,std::memory_order_acq_rel) == 1) {
+            delete box;
+        }
+    }
+    // 从原子字上换下来的 box：把还没归还的 local 个借用转移到 box->refs
+    static void retire(std::uint64_t old)noexcept {
+        Box *box = boxOf(old);
+        long local = static_cast<long>(old >> kShift);
+        if(box != nullptr && box->refs.fetch_add(local,std::memory_order_acq_rel) == -local) {
+            delete box;
+        }
+    }
+
+public:
+    static constexpr bool is_always_lock_free = false;
+
+    AtomicSharedPtr()noexcept:word_(0) {}
+    AtomicSharedPtr(SharedPtr<T> desired):word_(pack(makeBox(std::move(desired)))) {}
+    AtomicSharedPtr(AtomicSharedPtr const &) = delete;
+    AtomicSharedPtr &operator=(AtomicSharedPtr const &) = delete;
+    ~AtomicSharedPtr() {
+        retire(word_.load(std::memory_order_acquire));
+    }
+
+    bool is_lock_free()const noexcept {
+        return false;
+    }
+
+    SharedPtr<T> load()const noexcept {
+        std::uint64_t w = acquire();
+        Box *box = boxOf(w);
+        SharedPtr<T> result = box != nullptr ? box->value : SharedPtr<T>();
+        release(box);
+        return result;
+    }
+
+    operator SharedPtr<T>()const noexcept {
+        return load();
+    }
+
+    void store(SharedPtr<T> desired) {
+        retire(word_.exchange(pack(makeBox(std::move(desired))),std::memory_order_acq_rel));
+    }
+
+    AtomicSharedPtr &operator=(SharedPtr<T> desired) {
+        store(std::move(desired));
+        return *this;
+    }
+
+    SharedPtr<T> exchange(SharedPtr<T> desired) {
+        std::uint64_t old = word_.exchange(pack(makeBox(std::move(desired))),std::memory_order_acq_rel);
+        Box *box = boxOf(old);
+        // 换下来的 box 可能还有读者在复制，只能复制不能移动
+        SharedPtr<T> result = box != nullptr ? box->value : SharedPtr<T>();
+        retire(old);
+        return result;
+    }
+
+    // 与 std::atomic<std::shared_ptr> 相同：指针相同且共享所有权才算相等；失败时 expected 更新为当前值
+    bool compare_exchange_strong(SharedPtr<T> &expected,SharedPtr<T> desired) {
+        Box *fresh = makeBox(std::move(desired)); // 重试时复用
+        while(true) {
+            std::uint64_t w = acquire();
+            Box *box = boxOf(w);
+            bool equal = box != nullptr
+                             ? box->value.get() == expected.get() && box->value.owner_equal(expected)
+                             : expected.get() == nullptr && expected.use_count() == 0;
+            if(!equal) {
+                expected = box != nullptr ? box->value : SharedPtr<T>();
+                release(box);
+                if(fresh != nullptr) {
+                    delete fresh;
+                }
+                return false;
+            }
+            std::uint64_t cur = word_.load(std::memory_order_relaxed);
+            while(boxOf(cur) == box) {
+                if(word_.compare_exchange_weak(cur,pack(fresh),std::memory_order_acq_rel,std::memory_order_relaxed)) {
+                    retire(cur);  // cur 的本地计数里包含我们自己的借用
+                    release(box); // 此时 box 已不在原子字上，归还会落到 box->refs
+                    return true;
+                }
+            }
+            // box 被别人换掉了，值可能仍然相等，重新比较
+            release(box);
+        }
+    }
+
+    bool compare_exchange_weak(SharedPtr<T> &expected,SharedPtr<T> desired) {
+        return compare_exchange_strong(expected,std::move(desired));
+    }
+};
+
+#endif //ATOMIC_SHARED_PTR_HPP
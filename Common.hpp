@@ -31,9 +31,9 @@
           class = typename _Compare##Tp::is_transparent, \
           class = \
               decltype(std::declval<bool &>() = std::declval<_Compare##Tp>()( \
-                           std::declval<_Tv>(), std::declval<_Tp>()) = \
-                           std::declval<_Compare##Tp>()(std::declval<_Tp>(), \
-                                                        std::declval<_Tv>()))
+                           std::declval<_Tv>(), std::declval<_Tp>()), \
+                       std::declval<bool &>() = std::declval<_Compare##Tp>()( \
+                           std::declval<_Tp>(), std::declval<_Tv>()))
 
 // #define _LIBPENGCXX_THROW_OUT_OF_RANGE(__i, __n) throw std::runtime_error("out of range at index " + std::to_string(__i) + ", size " + std::to_string(__n))
 #define _LIBPENGCXX_THROW_OUT_OF_RANGE(__i, __n) throw std::out_of_range("")
@@ -48,6 +48,13 @@
 #define _LIBPENGCXX_UNREACHABLE() do {} while (1)
 #endif
 
+// 预取只是提示，不支持的编译器上什么都不做
+#if defined(__GNUC__) || defined(__clang__)
+#define _LIBPENGCXX_PREFETCH(__addr) __builtin_prefetch(__addr)
+#else
+#define _LIBPENGCXX_PREFETCH(__addr) ((void) 0)
+#endif
+
 // 方便生成比较函数
 #if __cpp_lib_three_way_comparison
 #define _LIBPENGCXX_DEFINE_COMPARISON(_Type) \
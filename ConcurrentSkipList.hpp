@@ -0,0 +1,750 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 无锁跳表，给多写者并发的有序场景使用
+/*
+ * 1. 每一层都是一条有序的 Harris 链表，next 指针最低位作为 "逻辑删除" 标记
+ * 2. 删除时先从高层到低层逐层打标记，第 0 层标记成功的线程即为删除者
+ * 3. 标记过的节点在后续的查找中被顺手摘除 (物理删除)
+ * 4. 节点由插入方和删除方各持有一份引用，两者都结束后才交给 epoch 回收
+ * 5. 线程第一次进入临界区时要登记 epoch 记录，可能抛出 bad_alloc，所以查找、删除和 begin() 都不是 noexcept
+ */
+#ifndef CONCURRENT_SKIP_LIST_HPP
+#define CONCURRENT_SKIP_LIST_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "Common.hpp"
+#include "Epoch.hpp"
+#include "Map.hpp"
+
+template<class _Tp>
+struct alignas(_Tp) alignas(std::atomic<std::uintptr_t>) _SkipListNode {
+    union {
+        _Tp _M_value;
+    }; // 同 _RbTreeNodeImpl，头节点不需要构造值
+    std::atomic<unsigned> _M_refs;
+    unsigned _M_height;
+    // 之后紧跟 _M_height 个 std::atomic<std::uintptr_t>，见 _M_tower()
+
+    _SkipListNode(unsigned __height) noexcept : _M_refs(2), _M_height(__height) {
+        for (unsigned __i = 0; __i < __height; ++__i) {
+            new(&_M_tower()[__i]) std::atomic<std::uintptr_t>(0);
+        }
+    }
+
+    ~_SkipListNode() noexcept {
+    }
+
+    std::atomic<std::uintptr_t> *_M_tower() noexcept {
+        return reinterpret_cast<std::atomic<std::uintptr_t> *>(this + 1);
+    }
+
+    std::atomic<std::uintptr_t> &_M_next(unsigned __level) noexcept {
+        return _M_tower()[__level];
+    }
+
+    static _SkipListNode *_S_ptr(std::uintptr_t __link) noexcept {
+        return reinterpret_cast<_SkipListNode *>(__link & ~std::uintptr_t(1));
+    }
+
+    static bool _S_marked(std::uintptr_t __link) noexcept {
+        return __link & 1;
+    }
+
+    static std::uintptr_t _S_link(_SkipListNode *__node) noexcept {
+        return reinterpret_cast<std::uintptr_t>(__node);
+    }
+
+    static std::size_t _S_bytes(unsigned __height) noexcept {
+        return sizeof(_SkipListNode) + __height * sizeof(std::atomic<std::uintptr_t>);
+    }
+
+    static _SkipListNode *_S_allocate(unsigned __height) {
+        void *__mem = ::operator new(_S_bytes(__height), std::align_val_t(alignof(_SkipListNode)));
+        return new(__mem) _SkipListNode(__height);
+    }
+
+    static void _S_deallocate(_SkipListNode *__node) noexcept {
+        std::size_t __bytes = _S_bytes(__node->_M_height);
+        __node->~_SkipListNode();
+        ::operator delete(static_cast<void *>(__node), __bytes, std::align_val_t(alignof(_SkipListNode)));
+    }
+
+    // 交给 epoch 回收时使用，不能依赖容器对象本身
+    static void _S_destroy(void *__ptr) noexcept {
+        auto *__node = static_cast<_SkipListNode *>(__ptr);
+        __node->_M_value.~_Tp();
+        _S_deallocate(__node);
+    }
+};
+
+// 指向节点的迭代器一直钉住 epoch，保证当前节点不会被释放；不能跨线程传递
+// end() 和默认构造的迭代器不钉 epoch，拿它们比较不需要进出临界区
+template<class _Node, class _Tp>
+struct _SkipListIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_const_t<_Tp>;
+    using reference = _Tp &;
+    using pointer = _Tp *;
+
+    _Node *_M_node;
+    _EpochRecord *_M_rec; // 只有 _M_node 不为空时才钉住
+
+    _SkipListIterator() noexcept : _M_node(nullptr), _M_rec(nullptr) {
+    }
+
+    // 当前线程第一次使用 epoch 时要登记记录，可能抛出 bad_alloc
+    explicit _SkipListIterator(_Node *__node) : _M_node(__node), _M_rec(nullptr) {
+        if (__node != nullptr) {
+            _M_rec = _EpochThreadHandle::_S_local();
+            _EpochDomain::_S_instance()._M_pin(_M_rec);
+        }
+    }
+
+    _SkipListIterator(_SkipListIterator const &__that) noexcept
+        : _M_node(__that._M_node), _M_rec(__that._M_rec) {
+        if (_M_rec != nullptr) {
+            _EpochDomain::_S_instance()._M_pin(_M_rec);
+        }
+    }
+
+    // 先钉住新的再放开旧的，自赋值时也不会有节点失去保护
+    _SkipListIterator &operator=(_SkipListIterator const &__that) noexcept {
+        if (__that._M_rec != nullptr) {
+            _EpochDomain::_S_instance()._M_pin(__that._M_rec);
+        }
+        this->_M_unpin();
+        _M_node = __that._M_node;
+        _M_rec = __that._M_rec;
+        return *this;
+    }
+
+    ~_SkipListIterator() noexcept {
+        this->_M_unpin();
+    }
+
+    bool operator==(_SkipListIterator const &__that) const noexcept {
+        return _M_node == __that._M_node;
+    }
+
+    bool operator!=(_SkipListIterator const &__that) const noexcept {
+        return _M_node != __that._M_node;
+    }
+
+    // 跳过已经被逻辑删除的节点
+    _SkipListIterator &operator++() noexcept {
+        _Node *__curr = _Node::_S_ptr(_M_node->_M_next(0).load(std::memory_order_acquire));
+        while (__curr != nullptr) {
+            std::uintptr_t __succ = __curr->_M_next(0).load(std::memory_order_acquire);
+            if (!_Node::_S_marked(__succ)) {
+                break;
+            }
+            __curr = _Node::_S_ptr(__succ);
+        }
+        _M_node = __curr;
+        if (__curr == nullptr) {
+            this->_M_unpin(); // 走到末尾就变成 end()，不再占着 epoch
+        }
+        return *this;
+    }
+
+    _SkipListIterator operator++(int) noexcept {
+        _SkipListIterator __tmp = *this;
+        ++*this;
+        return __tmp;
+    }
+
+    _Tp &operator*() const noexcept {
+        return _M_node->_M_value;
+    }
+
+    _Tp *operator->() const noexcept {
+        return std::addressof(_M_node->_M_value);
+    }
+
+private:
+    void _M_unpin() noexcept {
+        if (_M_rec != nullptr) {
+            _EpochDomain::_S_instance()._M_unpin(std::exchange(_M_rec, nullptr));
+        }
+    }
+};
+
+template<class _Tp, class _Compare>
+struct _SkipListImpl {
+protected:
+    using _Node = _SkipListNode<std::remove_const_t<_Tp>>;
+    static constexpr unsigned _S_max_height = 32;
+
+    [[no_unique_address]] _Compare _M_comp;
+    _Node *_M_head;
+    std::atomic<unsigned> _M_level; // 目前用到的最高层数，只增不减
+    std::atomic<std::size_t> _M_size;
+
+public:
+    using iterator = _SkipListIterator<_Node, _Tp>;
+    using const_iterator = _SkipListIterator<_Node, _Tp const>;
+
+    _SkipListImpl() : _SkipListImpl(_Compare()) {
+    }
+
+    explicit _SkipListImpl(_Compare __comp)
+        : _M_comp(__comp), _M_head(_Node::_S_allocate(_S_max_height)), _M_level(1), _M_size(0) {
+    }
+
+    _SkipListImpl(_SkipListImpl &&) = delete;
+
+    // 析构时不允许再有并发访问
+    ~_SkipListImpl() noexcept {
+        _Node *__curr = _Node::_S_ptr(_M_head->_M_next(0).load(std::memory_order_acquire));
+        while (__curr != nullptr) {
+            _Node *__next = _Node::_S_ptr(__curr->_M_next(0).load(std::memory_order_relaxed));
+            _Node::_S_destroy(__curr);
+            __curr = __next;
+        }
+        _Node::_S_deallocate(_M_head);
+    }
+
+    // 并发修改时只是一个近似值
+    std::size_t size() const noexcept {
+        return _M_size.load(std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return this->begin() == this->end();
+    }
+
+    iterator begin() {
+        iterator __it(_M_head);
+        ++__it;
+        return __it;
+    }
+
+    iterator end() noexcept {
+        return iterator();
+    }
+
+    const_iterator begin() const {
+        const_iterator __it(_M_head);
+        ++__it;
+        return __it;
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator();
+    }
+
+protected:
+    static unsigned _S_random_height() noexcept {
+        static thread_local std::uint32_t __state = static_cast<std::uint32_t>(
+            std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+        // xorshift32，每层晋升概率 1/2
+        __state ^= __state << 13;
+        __state ^= __state >> 17;
+        __state ^= __state << 5;
+        unsigned __height = 1;
+        std::uint32_t __bits = __state;
+        while ((__bits & 1) && __height < _S_max_height) {
+            ++__height;
+            __bits >>= 1;
+        }
+        return __height;
+    }
+
+    void _M_raise_level(unsigned __height) noexcept {
+        unsigned __level = _M_level.load(std::memory_order_relaxed);
+        while (__level < __height &&
+               !_M_level.compare_exchange_weak(__level, __height, std::memory_order_relaxed)) {
+        }
+    }
+
+    // 查找 __key 在每一层的前驱和后继，沿途摘除被标记的节点
+    // 返回第 0 层是否存在未被删除且等于 __key 的节点
+    template<class _Tv>
+    bool _M_find(_Tv const &__key, _Node **__preds, _Node **__succs) noexcept {
+    retry:
+        unsigned __top = _M_level.load(std::memory_order_acquire);
+        for (unsigned __lv = __top; __lv < _S_max_height; ++__lv) {
+            __preds[__lv] = _M_head;
+            __succs[__lv] = nullptr;
+        }
+        _Node *__pred = _M_head;
+        for (unsigned __lv = __top; __lv-- > 0;) {
+            _Node *__curr = _Node::_S_ptr(__pred->_M_next(__lv).load(std::memory_order_acquire));
+            while (__curr != nullptr) {
+                std::uintptr_t __succ = __curr->_M_next(__lv).load(std::memory_order_acquire);
+                if (_Node::_S_marked(__succ)) {
+                    std::uintptr_t __expected = _Node::_S_link(__curr);
+                    if (!__pred->_M_next(__lv).compare_exchange_strong(
+                        __expected, __succ & ~std::uintptr_t(1), std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                        goto retry;
+                    }
+                    __curr = _Node::_S_ptr(__succ);
+                    continue;
+                }
+                if (!_M_comp(__curr->_M_value, __key)) {
+                    break;
+                }
+                __pred = __curr;
+                __curr = _Node::_S_ptr(__succ);
+            }
+            __preds[__lv] = __pred;
+            __succs[__lv] = __curr;
+        }
+        return __succs[0] != nullptr && !_M_comp(__key, __succs[0]->_M_value);
+    }
+
+    // 只读查找，不做摘除，返回第 0 层第一个满足条件的未删除节点
+    // _Upper 为 false 时是 lower_bound (>= __key)，为 true 时是 upper_bound (> __key)
+    template<bool _Upper, class _Tv>
+    _Node *_M_bound(_Tv const &__key) const noexcept {
+        _Node *__pred = _M_head;
+        _Node *__curr = nullptr;
+        for (unsigned __lv = _M_level.load(std::memory_order_acquire); __lv-- > 0;) {
+            __curr = _Node::_S_ptr(__pred->_M_next(__lv).load(std::memory_order_acquire));
+            while (__curr != nullptr) {
+                std::uintptr_t __succ = __curr->_M_next(__lv).load(std::memory_order_acquire);
+                if (_Node::_S_marked(__succ)) {
+                    __curr = _Node::_S_ptr(__succ);
+                    continue;
+                }
+                bool __go_right;
+                if constexpr (_Upper) {
+                    __go_right = !_M_comp(__key, __curr->_M_value);
+                } else {
+                    __go_right = _M_comp(__curr->_M_value, __key);
+                }
+                if (!__go_right) {
+                    break;
+                }
+                __pred = __curr;
+                __curr = _Node::_S_ptr(__succ);
+            }
+        }
+        return __curr;
+    }
+
+    template<class _Tv>
+    _Node *_M_find_node(_Tv const &__key) const noexcept {
+        _Node *__node = this->_M_bound<false>(__key);
+        return __node != nullptr && !_M_comp(__key, __node->_M_value) ? __node : nullptr;
+    }
+
+    // 确保 __node 在所有层都已经被摘除
+    void _M_unlink(_Node *__node) noexcept {
+    retry:
+        _Node *__pred = _M_head; // 只记录严格小于 key 的前驱，相等的节点可能乱序
+        // 从最高层往下走，高于节点的层只用来定位前驱
+        for (unsigned __lv = _M_level.load(std::memory_order_acquire); __lv-- > 0;) {
+            _Node *__before = __pred;
+            _Node *__curr = _Node::_S_ptr(__before->_M_next(__lv).load(std::memory_order_acquire));
+            while (__curr != nullptr && !_M_comp(__node->_M_value, __curr->_M_value)) {
+                std::uintptr_t __succ = __curr->_M_next(__lv).load(std::memory_order_acquire);
+                if (_Node::_S_marked(__succ)) {
+                    std::uintptr_t __expected = _Node::_S_link(__curr);
+                    if (!__before->_M_next(__lv).compare_exchange_strong(
+                        __expected, __succ & ~std::uintptr_t(1), std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                        goto retry;
+                    }
+                    __curr = _Node::_S_ptr(__succ);
+                    continue;
+                }
+                if (_M_comp(__curr->_M_value, __node->_M_value)) {
+                    __pred = __curr;
+                }
+                __before = __curr;
+                __curr = _Node::_S_ptr(__succ);
+            }
+        }
+    }
+
+    void _M_release(_Node *__node, _EpochGuard &__guard) noexcept {
+        if (__node->_M_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            __guard._M_retire(__node, &_Node::_S_destroy);
+        }
+    }
+
+    template<class... _Ts>
+    std::pair<iterator, bool> _M_emplace(_Ts &&... __value) {
+        _EpochGuard __guard;
+        _Node *__preds[_S_max_height];
+        _Node *__succs[_S_max_height];
+        unsigned __height = _S_random_height();
+        _Node *__node = _Node::_S_allocate(__height);
+        try {
+            new(const_cast<std::remove_const_t<_Tp> *>(std::addressof(__node->_M_value)))
+                    std::remove_const_t<_Tp>(std::forward<_Ts>(__value)...);
+        } catch (...) {
+            _Node::_S_deallocate(__node);
+            throw;
+        }
+        this->_M_raise_level(__height);
+        while (true) {
+            if (this->_M_find(__node->_M_value, __preds, __succs)) {
+                _Node::_S_destroy(__node); // 尚未发布，直接释放
+                return {iterator(__succs[0]), false};
+            }
+            for (unsigned __lv = 0; __lv < __height; ++__lv) {
+                __node->_M_next(__lv).store(_Node::_S_link(__succs[__lv]), std::memory_order_relaxed);
+            }
+            std::uintptr_t __expected = _Node::_S_link(__succs[0]);
+            if (__preds[0]->_M_next(0).compare_exchange_strong(
+                __expected, _Node::_S_link(__node), std::memory_order_release,
+                std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        // 第 0 层链入即视为插入成功，再逐层往上链
+        for (unsigned __lv = 1; __lv < __height; ++__lv) {
+            while (true) {
+                std::uintptr_t __old = __node->_M_next(__lv).load(std::memory_order_acquire);
+                if (_Node::_S_marked(__old)) {
+                    goto linked; // 已经被删除，不再往上链
+                }
+                std::uintptr_t __want = _Node::_S_link(__succs[__lv]);
+                if (__old != __want &&
+                    !__node->_M_next(__lv).compare_exchange_strong(__old, __want, std::memory_order_acq_rel,
+                                                                   std::memory_order_relaxed)) {
+                    continue;
+                }
+                std::uintptr_t __expected = __want;
+                if (__preds[__lv]->_M_next(__lv).compare_exchange_strong(
+                    __expected, _Node::_S_link(__node), std::memory_order_release,
+                    std::memory_order_relaxed)) {
+                    break;
+                }
+                this->_M_find(__node->_M_value, __preds, __succs);
+                if (__succs[0] != __node) {
+                    goto linked;
+                }
+            }
+        }
+    linked:
+        _M_size.fetch_add(1, std::memory_order_relaxed);
+        // 删除者可能在我们链入高层之前就完成了摘除，这里再补一次
+        if (_Node::_S_marked(__node->_M_next(0).load(std::memory_order_acquire))) {
+            this->_M_unlink(__node);
+        }
+        iterator __it(__node);
+        this->_M_release(__node, __guard);
+        return {__it, true};
+    }
+
+    template<class _Tv>
+    std::size_t _M_erase(_Tv const &__key) {
+        _EpochGuard __guard;
+        _Node *__preds[_S_max_height];
+        _Node *__succs[_S_max_height];
+        if (!this->_M_find(__key, __preds, __succs)) {
+            return 0;
+        }
+        _Node *__node = __succs[0];
+        for (unsigned __lv = __node->_M_height; __lv-- > 1;) {
+            std::uintptr_t __succ = __node->_M_next(__lv).load(std::memory_order_acquire);
+            while (!_Node::_S_marked(__succ) &&
+                   !__node->_M_next(__lv).compare_exchange_weak(__succ, __succ | 1, std::memory_order_acq_rel,
+                                                                std::memory_order_acquire)) {
+            }
+        }
+        std::uintptr_t __succ = __node->_M_next(0).load(std::memory_order_acquire);
+        while (true) {
+            if (_Node::_S_marked(__succ)) {
+                return 0; // 别的线程抢先删除了
+            }
+            if (__node->_M_next(0).compare_exchange_weak(__succ, __succ | 1, std::memory_order_acq_rel,
+                                                         std::memory_order_acquire)) {
+                break;
+            }
+        }
+        this->_M_unlink(__node);
+        _M_size.fetch_sub(1, std::memory_order_relaxed);
+        this->_M_release(__node, __guard);
+        return 1;
+    }
+
+public:
+    template<class _Tv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    iterator lower_bound(_Tv &&__value) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<false>(__value));
+    }
+
+    template<class _Tv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    const_iterator lower_bound(_Tv &&__value) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<false>(__value));
+    }
+
+    template<class _Tv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    iterator upper_bound(_Tv &&__value) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<true>(__value));
+    }
+
+    template<class _Tv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    const_iterator upper_bound(_Tv &&__value) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<true>(__value));
+    }
+
+    iterator lower_bound(_Tp const &__value) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<false>(__value));
+    }
+
+    const_iterator lower_bound(_Tp const &__value) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<false>(__value));
+    }
+
+    iterator upper_bound(_Tp const &__value) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<true>(__value));
+    }
+
+    const_iterator upper_bound(_Tp const &__value) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<true>(__value));
+    }
+};
+
+template<class _Tp, class _Compare = std::less<_Tp> >
+struct ConcurrentSet : _SkipListImpl<_Tp const, _Compare> {
+    using typename _SkipListImpl<_Tp const, _Compare>::const_iterator;
+    using iterator = const_iterator;
+    using value_type = _Tp;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    ConcurrentSet() = default;
+
+    explicit ConcurrentSet(_Compare __comp)
+        : _SkipListImpl<_Tp const, _Compare>(__comp) {
+    }
+
+    _Compare value_comp() const noexcept {
+        return this->_M_comp;
+    }
+
+    template<class _Tv, _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    const_iterator find(_Tv &&__value) const {
+        _EpochGuard __guard;
+        return const_iterator(this->_M_find_node(__value));
+    }
+
+    const_iterator find(_Tp const &__value) const {
+        _EpochGuard __guard;
+        return const_iterator(this->_M_find_node(__value));
+    }
+
+    std::pair<iterator, bool> insert(_Tp &&__value) {
+        return this->_M_emplace(std::move(__value));
+    }
+
+    std::pair<iterator, bool> insert(_Tp const &__value) {
+        return this->_M_emplace(__value);
+    }
+
+    template<class... _Ts>
+    std::pair<iterator, bool> emplace(_Ts &&... __value) {
+        return this->_M_emplace(std::forward<_Ts>(__value)...);
+    }
+
+    template<class _Tv, _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    std::size_t erase(_Tv &&__value) {
+        return this->_M_erase(__value);
+    }
+
+    std::size_t erase(_Tp const &__value) {
+        return this->_M_erase(__value);
+    }
+
+    template<class _Tv, _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    std::size_t count(_Tv &&__value) const {
+        return this->contains(__value) ? 1 : 0;
+    }
+
+    std::size_t count(_Tp const &__value) const {
+        return this->contains(__value) ? 1 : 0;
+    }
+
+    template<class _Tv, _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
+    bool contains(_Tv &&__value) const {
+        _EpochGuard __guard;
+        return this->_M_find_node(__value) != nullptr;
+    }
+
+    bool contains(_Tp const &__value) const {
+        _EpochGuard __guard;
+        return this->_M_find_node(__value) != nullptr;
+    }
+};
+
+// 复用 Map 的 _RbTreeValueCompare，只比较 key
+template<class _Key, class _Mapped, class _Compare = std::less<_Key> >
+struct ConcurrentOrderedMap
+    : _SkipListImpl<std::pair<_Key const, _Mapped>,
+                    _RbTreeValueCompare<_Compare, std::pair<_Key const, _Mapped> > > {
+    using key_type = _Key;
+    using mapped_type = _Mapped;
+    using value_type = std::pair<_Key const, _Mapped>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    using _ValueComp = _RbTreeValueCompare<_Compare, value_type>;
+
+public:
+    using typename _SkipListImpl<value_type, _ValueComp>::iterator;
+    using typename _SkipListImpl<value_type, _ValueComp>::const_iterator;
+
+    ConcurrentOrderedMap() = default;
+
+    explicit ConcurrentOrderedMap(_Compare __comp)
+        : _SkipListImpl<value_type, _ValueComp>(__comp) {
+    }
+
+    _ValueComp value_comp() const noexcept {
+        return this->_M_comp;
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    iterator find(_Kv &&__key) {
+        _EpochGuard __guard;
+        return iterator(this->_M_find_node(__key));
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    const_iterator find(_Kv &&__key) const {
+        _EpochGuard __guard;
+        return const_iterator(this->_M_find_node(__key));
+    }
+
+    iterator find(_Key const &__key) {
+        _EpochGuard __guard;
+        return iterator(this->_M_find_node(__key));
+    }
+
+    const_iterator find(_Key const &__key) const {
+        _EpochGuard __guard;
+        return const_iterator(this->_M_find_node(__key));
+    }
+
+    std::pair<iterator, bool> insert(value_type &&__value) {
+        return this->_M_emplace(std::move(__value));
+    }
+
+    std::pair<iterator, bool> insert(value_type const &__value) {
+        return this->_M_emplace(__value);
+    }
+
+    template<class... _Vs>
+    std::pair<iterator, bool> emplace(_Vs &&... __value) {
+        return this->_M_emplace(std::forward<_Vs>(__value)...);
+    }
+
+    template<class... _Ms>
+    std::pair<iterator, bool> try_emplace(_Key const &__key, _Ms &&... __mapped) {
+        return this->_M_emplace(std::piecewise_construct, std::forward_as_tuple(__key),
+                                std::forward_as_tuple(std::forward<_Ms>(__mapped)...));
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    std::size_t erase(_Kv &&__key) {
+        return this->_M_erase(__key);
+    }
+
+    std::size_t erase(_Key const &__key) {
+        return this->_M_erase(__key);
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    std::size_t count(_Kv &&__key) const {
+        return this->contains(__key) ? 1 : 0;
+    }
+
+    std::size_t count(_Key const &__key) const {
+        return this->contains(__key) ? 1 : 0;
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    bool contains(_Kv &&__key) const {
+        _EpochGuard __guard;
+        return this->_M_find_node(__key) != nullptr;
+    }
+
+    bool contains(_Key const &__key) const {
+        _EpochGuard __guard;
+        return this->_M_find_node(__key) != nullptr;
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    iterator lower_bound(_Kv &&__key) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<false>(__key));
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    const_iterator lower_bound(_Kv &&__key) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<false>(__key));
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    iterator upper_bound(_Kv &&__key) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<true>(__key));
+    }
+
+    template<class _Kv,
+        _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
+    const_iterator upper_bound(_Kv &&__key) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<true>(__key));
+    }
+
+    iterator lower_bound(_Key const &__key) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<false>(__key));
+    }
+
+    const_iterator lower_bound(_Key const &__key) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<false>(__key));
+    }
+
+    iterator upper_bound(_Key const &__key) {
+        _EpochGuard __guard;
+        return iterator(this->template _M_bound<true>(__key));
+    }
+
+    const_iterator upper_bound(_Key const &__key) const {
+        _EpochGuard __guard;
+        return const_iterator(this->template _M_bound<true>(__key));
+    }
+};
+
+#endif //CONCURRENT_SKIP_LIST_HPP
@@ -0,0 +1,149 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// SharedPtr 的延迟释放：把大量对象的析构从请求线程挪到安全点或后台线程
+/*
+ * 1. SpDeferredReleaseScope 存活期间，当前线程上计数归零的控制块 (只限 SpAtomicPolicy) 挂到 scope 的列表里
+ * 2. 没有指定后台线程时，scope 结束或调用 spDrainRetired() 时在当前线程批量释放
+ * 3. 指定了 SpBackgroundReclaimer 时，每攒够 batch 个就整批交给后台线程，scope 结束时交出剩下的
+ * 4. 释放对象时产生的新的归零块 (对象内部还持有 SharedPtr) 会进入同一个列表，直到全部释放完
+ *    后台线程上也装了自己的列表，连锁产生的块在后台线程上逐批释放，不会在析构里层层递归
+ * 对象被延迟析构期间已经不能通过 SharedPtr/WeakPtr 访问 (WeakPtr::lock 会失败)，只是析构的时间和线程变了
+ */
+#ifndef DEFERRED_RELEASE_HPP
+#define DEFERRED_RELEASE_HPP
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "SmartPtr.hpp"
+
+inline void spReleaseAll(std::vector<SpRetired> &items) noexcept {
+    for(SpRetired &retired: items) {
+        retired.release(retired.cb);
+    }
+}
+
+// 在当前线程的安全点释放已经攒下的块，不在 scope 中时什么也不做
+inline void spDrainRetired() noexcept {
+    SpRetireList *list = SpRetireList::active();
+    if(!list) {
+        return;
+    }
+    while(!list->items.empty()) {
+        std::vector<SpRetired> batch = std::move(list->items);
+        list->items.clear();
+        spReleaseAll(batch);
+    }
+}
+
+// 后台释放线程：请求线程只付出一次加锁和 vector 拼接的代价
+struct SpBackgroundReclaimer {
+private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::vector<SpRetired> pending_;
+    std::size_t submitted_ = 0;
+    std::size_t released_ = 0;
+    bool stop_ = false;
+    std::thread worker_;    // 必须最后初始化
+
+    void run() noexcept {
+        // 释放时连锁归零的块挂到这里，由 spDrainRetired 逐批释放
+        SpRetireList chained;
+        SpRetireList::active() = &chained;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(;;) {
+            wake_.wait(lock,[this] { return stop_ || !pending_.empty(); });
+            if(pending_.empty()) {
+                return;
+            }
+            std::vector<SpRetired> batch = std::move(pending_);
+            pending_.clear();
+            lock.unlock();
+            spReleaseAll(batch);
+            spDrainRetired();
+            lock.lock();
+            released_ += batch.size();
+            idle_.notify_all();
+        }
+    }
+public:
+    SpBackgroundReclaimer():worker_([this] { run(); }) {}
+    SpBackgroundReclaimer(SpBackgroundReclaimer &&) = delete;
+    // 退出前释放所有已经提交的块
+    ~SpBackgroundReclaimer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+    // 成功时清空 items；抛出异常时 items 保持原样
+    void submit(std::vector<SpRetired> &items) {
+        if(items.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::size_t const count = items.size();
+            if(pending_.empty()) {
+                pending_.swap(items);
+            }else {
+                pending_.insert(pending_.end(),items.begin(),items.end());
+            }
+            submitted_ += count;
+        }
+        items.clear();
+        wake_.notify_one();
+    }
+    // 等待调用之前提交的块全部释放完
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::size_t target = submitted_;
+        idle_.wait(lock,[&] { return released_ >= target; });
+    }
+};
+
+struct SpDeferredReleaseScope {
+private:
+    SpRetireList list_;
+    SpRetireList *prev_;
+
+    static void handoffTo(SpRetireList &list) noexcept {
+        try {
+            static_cast<SpBackgroundReclaimer *>(list.owner)->submit(list.items);
+        }catch(...) {
+            // 交不出去就留在本地，scope 结束时在当前线程释放
+        }
+    }
+public:
+    static constexpr std::size_t kDefaultBatch = 1024;
+
+    // 攒到 scope 结束 (或 spDrainRetired) 时在当前线程释放
+    SpDeferredReleaseScope()noexcept:prev_(std::exchange(SpRetireList::active(),&list_)) {}
+    // 每攒够 batch 个就交给 reclaimer
+    explicit SpDeferredReleaseScope(SpBackgroundReclaimer &reclaimer,std::size_t batch = kDefaultBatch)noexcept:
+        prev_(std::exchange(SpRetireList::active(),&list_)) {
+        list_.batch = batch;
+        list_.owner = &reclaimer;
+        list_.handoff = &SpDeferredReleaseScope::handoffTo;
+    }
+    SpDeferredReleaseScope(SpDeferredReleaseScope &&) = delete;
+    ~SpDeferredReleaseScope() {
+        if(list_.handoff) {
+            handoffTo(list_);
+        }
+        spDrainRetired();
+        SpRetireList::active() = prev_;
+    }
+    std::size_t pending()const noexcept {
+        return list_.items.size();
+    }
+};
+
+#endif //DEFERRED_RELEASE_HPP
@@ -0,0 +1,211 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 基于 epoch 的内存回收 (EBR)，供无锁容器延迟释放被摘除的节点
+/*
+ * 1. 线程在访问共享结构之前 "钉住" 当前的全局 epoch，访问结束后解除
+ * 2. 被摘除的节点不立刻释放，而是带着摘除时的 epoch 挂到线程本地的待回收列表
+ * 3. 只有当所有活跃线程都进入了当前 epoch，全局 epoch 才能推进
+ * 4. 全局 epoch 比节点的 epoch 大 2 时，已经没有线程可能持有该节点，可以安全释放
+ */
+#ifndef EPOCH_HPP
+#define EPOCH_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+struct _EpochRetired {
+    void *_M_ptr;
+    void (*_M_deleter)(void *) noexcept;
+    std::uint64_t _M_epoch; // 摘除时看到的全局 epoch
+};
+
+struct _EpochRecord {
+    // 0 表示不在临界区，否则为 (epoch << 1) | 1
+    std::atomic<std::uint64_t> _M_state{0};
+    std::atomic<bool> _M_in_use{false};
+    _EpochRecord *_M_next{nullptr}; // 全局链表，只增不减
+    // 以下成员只会被占用该记录的线程访问
+    unsigned _M_nesting{0};
+    std::vector<_EpochRetired> _M_limbo;
+};
+
+struct _EpochDomain {
+private:
+    std::atomic<std::uint64_t> _M_global{2};
+    std::atomic<_EpochRecord *> _M_records{nullptr};
+    std::mutex _M_orphan_mutex; // 只在线程退出时使用，属于冷路径
+    std::vector<_EpochRetired> _M_orphans;
+
+    static constexpr std::size_t _S_collect_threshold = 64;
+
+public:
+    static _EpochDomain &_S_instance() noexcept {
+        static _EpochDomain __domain;
+        return __domain;
+    }
+
+    _EpochDomain() = default;
+    _EpochDomain(_EpochDomain &&) = delete;
+
+    ~_EpochDomain() noexcept {
+        // 程序退出时所有线程都已离开临界区
+        for (_EpochRetired &__r: _M_orphans) {
+            __r._M_deleter(__r._M_ptr);
+        }
+        _EpochRecord *__rec = _M_records.load(std::memory_order_acquire);
+        while (__rec != nullptr) {
+            _EpochRecord *__next = __rec->_M_next;
+            for (_EpochRetired &__r: __rec->_M_limbo) {
+                __r._M_deleter(__r._M_ptr);
+            }
+            delete __rec;
+            __rec = __next;
+        }
+    }
+
+    _EpochRecord *_M_acquire_record() {
+        for (_EpochRecord *__rec = _M_records.load(std::memory_order_acquire);
+             __rec != nullptr; __rec = __rec->_M_next) {
+            bool __expected = false;
+            if (!__rec->_M_in_use.load(std::memory_order_relaxed) &&
+                __rec->_M_in_use.compare_exchange_strong(__expected, true, std::memory_order_acquire)) {
+                return __rec;
+            }
+        }
+        auto *__rec = new _EpochRecord;
+        __rec->_M_in_use.store(true, std::memory_order_relaxed);
+        _EpochRecord *__head = _M_records.load(std::memory_order_relaxed);
+        do {
+            __rec->_M_next = __head;
+        } while (!_M_records.compare_exchange_weak(__head, __rec, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+        return __rec;
+    }
+
+    void _M_release_record(_EpochRecord *__rec) noexcept {
+        this->_M_collect(__rec);
+        if (!__rec->_M_limbo.empty()) {
+            std::lock_guard<std::mutex> __lock(_M_orphan_mutex);
+            _M_orphans.insert(_M_orphans.end(), __rec->_M_limbo.begin(), __rec->_M_limbo.end());
+        }
+        __rec->_M_limbo.clear();
+        __rec->_M_limbo.shrink_to_fit();
+        __rec->_M_state.store(0, std::memory_order_release);
+        __rec->_M_in_use.store(false, std::memory_order_release);
+    }
+
+    void _M_pin(_EpochRecord *__rec) noexcept {
+        if (__rec->_M_nesting++ == 0) {
+            std::uint64_t __e = _M_global.load(std::memory_order_relaxed);
+            __rec->_M_state.store((__e << 1) | 1, std::memory_order_relaxed);
+            // 必须先公开自己处于临界区，再读取任何共享指针
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void _M_unpin(_EpochRecord *__rec) noexcept {
+        if (--__rec->_M_nesting == 0) {
+            __rec->_M_state.store(0, std::memory_order_release);
+        }
+    }
+
+    void _M_retire(_EpochRecord *__rec, void *__ptr, void (*__deleter)(void *) noexcept) {
+        // 与 _M_pin 中的 fence 配对: 若读者的 fence 在前，读者看到的 epoch 不会超过这里读到的值；
+        // 若在后，读者一定能看到摘除操作，拿不到 __ptr
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        __rec->_M_limbo.push_back({__ptr, __deleter, _M_global.load(std::memory_order_relaxed)});
+        if (__rec->_M_limbo.size() % _S_collect_threshold == 0) {
+            this->_M_try_advance();
+            this->_M_collect(__rec);
+        }
+    }
+
+    // 所有活跃线程都已看到当前 epoch 时才推进
+    bool _M_try_advance() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t __e = _M_global.load(std::memory_order_relaxed);
+        for (_EpochRecord *__rec = _M_records.load(std::memory_order_acquire);
+             __rec != nullptr; __rec = __rec->_M_next) {
+            std::uint64_t __s = __rec->_M_state.load(std::memory_order_relaxed);
+            if ((__s & 1) && (__s >> 1) != __e) {
+                return false;
+            }
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _M_global.compare_exchange_strong(__e, __e + 1, std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed);
+    }
+
+    void _M_collect(_EpochRecord *__rec) noexcept {
+        std::uint64_t __e = _M_global.load(std::memory_order_acquire);
+        _M_free_expired(__rec->_M_limbo, __e);
+        // 顺带回收已退出线程留下的节点，拿不到锁就下次再说
+        std::unique_lock<std::mutex> __lock(_M_orphan_mutex, std::try_to_lock);
+        if (__lock.owns_lock()) {
+            _M_free_expired(_M_orphans, __e);
+        }
+    }
+
+private:
+    static void _M_free_expired(std::vector<_EpochRetired> &__list, std::uint64_t __e) noexcept {
+        auto __keep = std::partition(__list.begin(), __list.end(), [__e](_EpochRetired const &__r) {
+            return __r._M_epoch + 2 > __e;
+        });
+        for (auto __it = __keep; __it != __list.end(); ++__it) {
+            __it->_M_deleter(__it->_M_ptr);
+        }
+        __list.erase(__keep, __list.end());
+    }
+};
+
+// 每个线程在第一次使用时占用一条记录，线程退出时归还
+struct _EpochThreadHandle {
+    _EpochRecord *_M_rec;
+
+    _EpochThreadHandle() : _M_rec(_EpochDomain::_S_instance()._M_acquire_record()) {
+    }
+
+    ~_EpochThreadHandle() noexcept {
+        _EpochDomain::_S_instance()._M_release_record(_M_rec);
+    }
+
+    static _EpochRecord *_S_local() {
+        static thread_local _EpochThreadHandle __handle;
+        return __handle._M_rec;
+    }
+};
+
+// RAII 形式的临界区，可以嵌套和复制 (复制即再钉一次)
+struct _EpochGuard {
+private:
+    _EpochRecord *_M_rec;
+
+public:
+    _EpochGuard() : _M_rec(_EpochThreadHandle::_S_local()) {
+        _EpochDomain::_S_instance()._M_pin(_M_rec);
+    }
+
+    _EpochGuard(_EpochGuard const &__that) noexcept : _M_rec(__that._M_rec) {
+        _EpochDomain::_S_instance()._M_pin(_M_rec);
+    }
+
+    _EpochGuard &operator=(_EpochGuard const &) noexcept {
+        return *this; // 同一线程内的记录都相同，无需改动
+    }
+
+    ~_EpochGuard() noexcept {
+        _EpochDomain::_S_instance()._M_unpin(_M_rec);
+    }
+
+    // 把已经摘除的对象交给 domain，等所有读者离开后再调用 __deleter
+    void _M_retire(void *__ptr, void (*__deleter)(void *) noexcept) {
+        _EpochDomain::_S_instance()._M_retire(_M_rec, __ptr, __deleter);
+    }
+};
+
+#endif //EPOCH_HPP
@@ -0,0 +1,168 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 侵入式引用计数指针：计数放在对象自身里，没有控制块，句柄只有一个指针
+/*
+ * 1. 对象继承 IntrusiveRefCounted<Derived,Policy>，计数的原子性沿用 SmartPtr 的 SpAtomicPolicy / SpNonAtomicPolicy
+ * 2. IntrusivePtr<T> 只通过 intrusive_add_ref / intrusive_release 两个成员操作计数，T 也可以自己提供这两个函数
+ * 3. 和 SharedPtr 互转: toShared 得到的 SharedPtr 只持有一个侵入式引用，对象的寿命始终由对象里的计数决定；
+ *    反过来只要对象已经被 IntrusivePtr 管理，就可以从 SharedPtr 或裸指针 (例如 this) 重新得到 IntrusivePtr
+ *    toIntrusive 遇到侵入式计数为 0 的对象 (例如来自 makeShared) 返回空指针，不会接管 SharedPtr 的对象
+ */
+#ifndef INTRUSIVE_PTR_HPP
+#define INTRUSIVE_PTR_HPP
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "SmartPtr.hpp"
+
+template<class Derived,class Policy = SpAtomicPolicy>
+struct IntrusiveRefCounted {
+private:
+    mutable typename Policy::counter_type refs_{0};
+public:
+    IntrusiveRefCounted()noexcept {}
+    // 复制对象不复制计数，新对象还没有任何持有者
+    IntrusiveRefCounted(IntrusiveRefCounted const &)noexcept {}
+    IntrusiveRefCounted &operator=(IntrusiveRefCounted const &)noexcept {
+        return *this;
+    }
+    // 增加引用的一方已经持有一个引用 (或刚创建对象)，relaxed 即可
+    void intrusive_add_ref() const noexcept {
+        Policy::add(refs_,1);
+    }
+    // 与 SpControlBlock::deref 相同：release 减计数，归零的一方 acquire 之后再 delete
+    void intrusive_release() const noexcept {
+        if(Policy::sub_release(refs_,1) == 1) {
+            Policy::acquire_after_release(refs_);
+            delete static_cast<Derived const *>(this);
+        }
+    }
+    long use_count() const noexcept {
+        return static_cast<long>(Policy::load_relaxed(refs_));
+    }
+protected:
+    ~IntrusiveRefCounted() = default;
+};
+
+template<class T>
+struct IntrusivePtr {
+private:
+    T *ptr_ = nullptr;
+    template<class>
+    friend struct IntrusivePtr;
+public:
+    using element_type = T;
+    using pointer = T*;
+    IntrusivePtr(std::nullptr_t = nullptr)noexcept {}
+    // add_ref 为 false 时接管调用者已经持有的引用 (与 detach 配对)
+    explicit IntrusivePtr(T *ptr,bool add_ref = true)noexcept:ptr_(ptr) {
+        if(ptr_ && add_ref) ptr_->intrusive_add_ref();
+    }
+    IntrusivePtr(IntrusivePtr const &that)noexcept:ptr_(that.ptr_) {
+        if(ptr_) ptr_->intrusive_add_ref();
+    }
+    IntrusivePtr(IntrusivePtr &&that)noexcept:ptr_(std::exchange(that.ptr_,nullptr)) {}
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    IntrusivePtr(IntrusivePtr<Y> const &that)noexcept:ptr_(that.ptr_) {
+        if(ptr_) ptr_->intrusive_add_ref();
+    }
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    IntrusivePtr(IntrusivePtr<Y> &&that)noexcept:ptr_(std::exchange(that.ptr_,nullptr)) {}
+    ~IntrusivePtr() {
+        if(ptr_) ptr_->intrusive_release();
+    }
+    // 先加新的再减旧的，自赋值和互相持有的对象都不会提前销毁
+    IntrusivePtr &operator=(IntrusivePtr const &that)noexcept {
+        IntrusivePtr(that).swap(*this);
+        return *this;
+    }
+    IntrusivePtr &operator=(IntrusivePtr &&that)noexcept {
+        IntrusivePtr(std::move(that)).swap(*this);
+        return *this;
+    }
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    IntrusivePtr &operator=(IntrusivePtr<Y> const &that)noexcept {
+        IntrusivePtr(that).swap(*this);
+        return *this;
+    }
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    IntrusivePtr &operator=(IntrusivePtr<Y> &&that)noexcept {
+        IntrusivePtr(std::move(that)).swap(*this);
+        return *this;
+    }
+    void reset()noexcept {
+        IntrusivePtr().swap(*this);
+    }
+    void reset(T *ptr,bool add_ref = true)noexcept {
+        IntrusivePtr(ptr,add_ref).swap(*this);
+    }
+    // 交出引用但不减计数，之后要用 IntrusivePtr(ptr,false) 接回来
+    T *detach()noexcept {
+        return std::exchange(ptr_,nullptr);
+    }
+    void swap(IntrusivePtr &that)noexcept {
+        std::swap(ptr_,that.ptr_);
+    }
+    T *get()const noexcept {
+        return ptr_;
+    }
+    T &operator*()const noexcept {
+        return *ptr_;
+    }
+    T *operator->()const noexcept {
+        return ptr_;
+    }
+    explicit operator bool()const noexcept {
+        return ptr_ != nullptr;
+    }
+    long use_count()const noexcept {
+        return ptr_?ptr_->use_count():0;
+    }
+    template<class Y>
+    bool operator==(IntrusivePtr<Y> const &that)const noexcept {
+        return ptr_ == that.ptr_;
+    }
+    bool operator==(std::nullptr_t)const noexcept {
+        return ptr_ == nullptr;
+    }
+    template<class Y>
+    bool operator<(IntrusivePtr<Y> const &that)const noexcept {
+        return ptr_ < that.ptr_;
+    }
+
+    // 转成 SharedPtr：控制块的删除器只归还一个侵入式引用，不直接 delete 对象
+    template<class Policy = SpAtomicPolicy>
+    SharedPtr<T,Policy> toShared()const {
+        if(!ptr_) return nullptr;
+        ptr_->intrusive_add_ref();
+        try {
+            return SharedPtr<T,Policy>(ptr_,[](T *ptr)noexcept {
+                ptr->intrusive_release();
+            });
+        }catch(...) {
+            ptr_->intrusive_release();
+            throw;
+        }
+    }
+};
+
+// 相当于 makeShared，但只有一次分配且没有控制块
+template<class T,class...Args>
+IntrusivePtr<T> makeIntrusive(Args&&...args) {
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+// 只有已经由侵入式计数管理的对象 (来自 makeIntrusive 或 toShared) 才能转换，否则返回空指针：
+// 计数为 0 说明对象归 SharedPtr 的控制块所有，接管它会让两边都去销毁对象
+// 计数不会在检查之后降到 0，因为 ptr 自己就持有一个侵入式引用
+template<class T,class Policy>
+IntrusivePtr<T> toIntrusive(SharedPtr<T,Policy> const &ptr)noexcept {
+    if(ptr.get() == nullptr || ptr->use_count() == 0) {
+        return IntrusivePtr<T>();
+    }
+    return IntrusivePtr<T>(ptr.get());
+}
+
+#endif //INTRUSIVE_PTR_HPP
@@ -49,12 +49,15 @@ struct _RbTreeValueCompare<
         : _M_comp(__comp) {
     }
 
+    // 两边都是 _Value 时交给下面的重载，否则非 const 的 _Value 实参会让两个模板产生歧义
     template<class _Lhs>
+        requires (!std::is_same_v<std::remove_cvref_t<_Lhs>, _Value>)
     bool operator()(_Lhs &&__lhs, _Value const &__rhs) const noexcept {
         return this->_M_comp(__lhs, __rhs.first);
     }
 
     template<class _Rhs>
+        requires (!std::is_same_v<std::remove_cvref_t<_Rhs>, _Value>)
     bool operator()(_Value const &__lhs, _Rhs &&__rhs) const noexcept {
         return this->_M_comp(__lhs.first, __rhs);
     }
@@ -67,11 +70,13 @@ struct _RbTreeValueCompare<
 };
 
 template <class _Key, class _Mapped, class _Compare = std::less<_Key>,
-          class _Alloc = std::allocator<std::pair<_Key const, _Mapped>>>
+          class _Alloc = std::allocator<std::pair<_Key const, _Mapped>>,
+          class _NodeImpl = _RbTreeNodeImpl<std::pair<_Key const, _Mapped>>,
+          class _Stats = _RbTreeNoStats>
 struct Map
     : _RbTreeImpl<std::pair<_Key const, _Mapped>,
                   _RbTreeValueCompare<_Compare, std::pair<_Key const, _Mapped>>,
-                  _Alloc> {
+                  _Alloc, _NodeImpl, _Stats> {
     using key_type = _Key;
     using mapped_type = _Mapped;
     using value_type = std::pair<_Key const, _Mapped>;
@@ -82,21 +87,21 @@ private:
     using _ValueComp = _RbTreeValueCompare<_Compare, value_type>;
 
 public:
-    using typename _RbTreeImpl<value_type, _ValueComp, _Alloc>::iterator;
-    using typename _RbTreeImpl<value_type, _ValueComp, _Alloc>::const_iterator;
-    using typename _RbTreeImpl<value_type, _ValueComp, _Alloc>::node_type;
+    using typename _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>::iterator;
+    using typename _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>::const_iterator;
+    using typename _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>::node_type;
 
     Map() = default;
 
     explicit Map(_Compare __comp)
-        : _RbTreeImpl<value_type, _ValueComp, _Alloc>(__comp) {}
+        : _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>(__comp) {}
 
     Map(std::initializer_list<value_type> __ilist) {
         _M_single_insert(__ilist.begin(), __ilist.end());
     }
 
     explicit Map(std::initializer_list<value_type> __ilist, _Compare __comp)
-        : _RbTreeImpl<value_type, _ValueComp, _Alloc>(__comp) {
+        : _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>(__comp) {
         _M_single_insert(__ilist.begin(), __ilist.end());
     }
 
@@ -109,14 +114,14 @@ public:
     template <_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator,
                                                      _InputIt)>
     explicit Map(_InputIt __first, _InputIt __last, _Compare __comp)
-        : _RbTreeImpl<value_type, _ValueComp, _Alloc>(__comp) {
+        : _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>(__comp) {
         _M_single_insert(__first, __last);
     }
 
     Map(Map &&) = default;
     Map &operator=(Map &&) = default;
 
-    Map(Map const &__that) : _RbTreeImpl<value_type, _ValueComp, _Alloc>() {
+    Map(Map const &__that) : _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>() {
         this->_M_single_insert(__that.begin(), __that.end());
     }
 
@@ -280,20 +285,20 @@ public:
 
     template <_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator,
                                                      _InputIt)>
-    iterator insert(_InputIt __first, _InputIt __last) {
-        return this->_M_single_insert(__first, __last);
+    void insert(_InputIt __first, _InputIt __last) {
+        this->_M_single_insert(__first, __last);
     }
 
-    using _RbTreeImpl<value_type, _ValueComp, _Alloc>::assign;
+    using _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>::assign;
 
     template <_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator,
                                                      _InputIt)>
-    iterator assign(_InputIt __first, _InputIt __last) {
+    void assign(_InputIt __first, _InputIt __last) {
         this->clear();
-        return this->_M_single_insert(__first, __last);
+        this->_M_single_insert(__first, __last);
     }
 
-    using _RbTreeImpl<value_type, _ValueComp, _Alloc>::erase;
+    using _RbTreeImpl<value_type, _ValueComp, _Alloc, _NodeImpl, _Stats>::erase;
 
     template <class _Kv,
               _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_ValueComp, _Kv, value_type)>
@@ -338,4 +343,16 @@ public:
     }
 };
 
+// 迭代器 ++/-- 只需一次指针读取的版本，适合大量区间扫描的场景
+template <class _Key, class _Mapped, class _Compare = std::less<_Key>,
+          class _Alloc = std::allocator<std::pair<_Key const, _Mapped>>>
+using ThreadedMap = Map<_Key, _Mapped, _Compare, _Alloc,
+                        _RbTreeThreadedNodeImpl<std::pair<_Key const, _Mapped>>>;
+
+// 统计比较、旋转、修复循环和节点分配次数的版本，通过 stats() / reset_stats() 读取和清零
+template <class _Key, class _Mapped, class _Compare = std::less<_Key>,
+          class _Alloc = std::allocator<std::pair<_Key const, _Mapped>>>
+using InstrumentedMap = Map<_Key, _Mapped, _Compare, _Alloc,
+                            _RbTreeNodeImpl<std::pair<_Key const, _Mapped>>, _RbTreeStats>;
+
 #endif //MAP_H
@@ -0,0 +1,375 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 多线程的对象池：反复创建和销毁同一类型的对象时复用内存，不走系统分配器
+/*
+ * 1. 内存按块 (chunk) 向系统申请，切成定长的节点，池子析构时整块归还；池子必须比它分出去的对象活得久
+ * 2. 每个线程对每个池子有一个本地缓存，分配和释放只碰本地缓存，不加锁
+ * 3. 本地缓存空了从共享的溢出链表一次取一批 (没有就切新的节点)，超过上限时把一半还给溢出链表，都要加锁
+ * 4. 线程退出时本地缓存还给溢出链表；池子已经析构的缓存直接丢弃 (内存已经随池子归还)
+ * 5. 统计: hits 是本地缓存命中的次数，misses 是需要访问共享链表的次数，highWater 是切出过的节点总数
+ *    hits 先记在线程本地，在访问共享链表、调用 flushLocal() 或线程退出时才累加到池子上
+ */
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "PoolAllocator.hpp"
+#include "SmartPtr.hpp"
+
+struct ObjectPoolStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t highWater = 0;
+};
+
+class ObjectPoolCore;
+
+// 一个线程对一个池子的本地缓存
+struct ObjectPoolLocal {
+    struct Node {
+        Node *next;
+    };
+    std::uint64_t id;       // 池子的编号，永不复用，用来判断池子是否还活着
+    ObjectPoolCore *core;
+    Node *head = nullptr;
+    std::size_t count = 0;
+    std::uint64_t hits = 0;
+};
+
+struct ObjectPoolLocals {
+    std::vector<ObjectPoolLocal> entries;
+    std::size_t last = 0;   // 上一次用到的下标，大多数线程只用一两个池子
+
+    ObjectPoolLocals() = default;
+    ObjectPoolLocals(ObjectPoolLocals &&) = delete;
+    inline ~ObjectPoolLocals();
+
+    // 线程退出时本对象可能先于其它 thread_local 析构，之后的释放直接还给共享链表
+    // 标记放在没有析构函数的 thread_local 里，本对象析构之后也能读
+    static bool &exiting() noexcept {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    static ObjectPoolLocals &get() noexcept {
+        static thread_local ObjectPoolLocals locals;
+        return locals;
+    }
+};
+
+// 与类型无关的定长节点池
+class ObjectPoolCore {
+public:
+    using Node = ObjectPoolLocal::Node;
+    static constexpr std::size_t kLocalMax = 256;   // 本地缓存的上限
+    static constexpr std::size_t kBatch = 64;       // 与共享链表之间一次搬运的个数
+    static constexpr std::size_t kChunkBytes = 64 * 1024;
+
+private:
+    std::size_t const align_;
+    std::size_t const size_;
+    std::uint64_t const id_;
+    std::mutex mutex_;
+    Node *shared_ = nullptr;
+    std::vector<void *> chunks_;
+    char *bump_ = nullptr;      // 当前 chunk 里还没切出去的部分
+    std::size_t bumpLeft_ = 0;
+    std::uint64_t misses_ = 0;
+    std::uint64_t carved_ = 0;
+    std::atomic<std::uint64_t> hits_{0};
+
+    friend struct ObjectPoolLocals;
+
+    // 活着的池子的编号；线程退出时持有这把锁把缓存还回去，池子析构时也要先拿到它
+    static std::mutex &registryMutex() noexcept {
+        static std::mutex mutex;
+        return mutex;
+    }
+    static std::unordered_set<std::uint64_t> &registry() {
+        static std::unordered_set<std::uint64_t> ids;
+        return ids;
+    }
+    static std::uint64_t nextId() noexcept {
+        static std::atomic<std::uint64_t> id{0};
+        return id.fetch_add(1,std::memory_order_relaxed) + 1;
+    }
+
+    std::size_t chunkNodes() const noexcept {
+        return std::max(kBatch,kChunkBytes / size_);
+    }
+
+    // 调用者持有 mutex_
+    Node *carve() {
+        if(bumpLeft_ == 0) {
+            std::size_t const nodes = chunkNodes();
+            chunks_.reserve(chunks_.size() + 1);
+            bump_ = static_cast<char *>(::operator new(nodes * size_,std::align_val_t(align_)));
+            chunks_.push_back(bump_);
+            bumpLeft_ = nodes;
+        }
+        Node *node = reinterpret_cast<Node *>(bump_);
+        bump_ += size_;
+        --bumpLeft_;
+        ++carved_;
+        return node;
+    }
+
+    void refill(ObjectPoolLocal &local) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++misses_;
+        hits_.fetch_add(std::exchange(local.hits,0),std::memory_order_relaxed);
+        for(std::size_t i = 0; i < kBatch; ++i) {
+            Node *node = shared_;
+            if(node != nullptr) {
+                shared_ = node->next;
+            }else {
+                try {
+                    node = carve();
+                }catch(...) {
+                    if(local.head != nullptr) {
+                        return; // 已经取到的够这次用
+                    }
+                    throw;
+                }
+            }
+            node->next = local.head;
+            local.head = node;
+            ++local.count;
+        }
+    }
+
+    // 把本地缓存的前 n 个节点还给共享链表
+    void spill(ObjectPoolLocal &local,std::size_t n) noexcept {
+        if(n == 0) {
+            return;
+        }
+        Node *first = local.head;
+        Node *last = first;
+        for(std::size_t i = 1; i < n; ++i) {
+            last = last->next;
+        }
+        local.head = last->next;
+        local.count -= n;
+        std::lock_guard<std::mutex> lock(mutex_);
+        hits_.fetch_add(std::exchange(local.hits,0),std::memory_order_relaxed);
+        last->next = shared_;
+        shared_ = first;
+    }
+
+    void pushShared(void *ptr) noexcept {
+        Node *node = static_cast<Node *>(ptr);
+        std::lock_guard<std::mutex> lock(mutex_);
+        node->next = shared_;
+        shared_ = node;
+    }
+
+    // 找到当前线程对本池子的缓存，第一次使用时登记；登记失败 (内存不足或线程正在退出) 返回空
+    ObjectPoolLocal *local() noexcept {
+        if(ObjectPoolLocals::exiting()) {
+            return nullptr;
+        }
+        ObjectPoolLocals &locals = ObjectPoolLocals::get();
+        if(locals.last < locals.entries.size() && locals.entries[locals.last].id == id_) {
+            return &locals.entries[locals.last];
+        }
+        for(std::size_t i = 0; i < locals.entries.size(); ++i) {
+            if(locals.entries[i].id == id_) {
+                locals.last = i;
+                return &locals.entries[i];
+            }
+        }
+        try {
+            {
+                // 顺便清掉已经析构的池子留下的缓存
+                std::lock_guard<std::mutex> lock(registryMutex());
+                std::erase_if(locals.entries,[](ObjectPoolLocal const &e) {
+                    return registry().count(e.id) == 0;
+                });
+            }
+            locals.entries.push_back({id_,this});
+        }catch(...) {
+            return nullptr;
+        }
+        locals.last = locals.entries.size() - 1;
+        return &locals.entries.back();
+    }
+
+public:
+    ObjectPoolCore(std::size_t size,std::size_t align):
+        align_(std::max(align,alignof(Node))),
+        size_((std::max(size,sizeof(Node)) + align_ - 1) / align_ * align_),
+        id_(nextId()) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().insert(id_);
+    }
+    ObjectPoolCore(ObjectPoolCore &&) = delete;
+
+    ~ObjectPoolCore() {
+        {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            registry().erase(id_);
+        }
+        for(void *chunk: chunks_) {
+            ::operator delete(chunk,std::align_val_t(align_));
+        }
+    }
+
+    void *allocate() {
+        ObjectPoolLocal *local = this->local();
+        if(local == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++misses_;
+            if(Node *node = shared_) {
+                shared_ = node->next;
+                return node;
+            }
+            return carve();
+        }
+        if(local->head == nullptr) {
+            refill(*local);
+        }else {
+            ++local->hits;
+        }
+        Node *node = local->head;
+        local->head = node->next;
+        --local->count;
+        return node;
+    }
+
+    void deallocate(void *ptr) noexcept {
+        ObjectPoolLocal *local = this->local();
+        if(local == nullptr) {
+            pushShared(ptr);
+            return;
+        }
+        Node *node = static_cast<Node *>(ptr);
+        node->next = local->head;
+        local->head = node;
+        if(++local->count > kLocalMax) {
+            spill(*local,kLocalMax / 2);
+        }
+    }
+
+    // 把当前线程的缓存和计数交还给池子
+    void flushLocal() noexcept {
+        if(ObjectPoolLocal *local = this->local()) {
+            spill(*local,local->count);
+            hits_.fetch_add(std::exchange(local->hits,0),std::memory_order_relaxed);
+        }
+    }
+
+    ObjectPoolStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {hits_.load(std::memory_order_relaxed),misses_,carved_};
+    }
+};
+
+inline ObjectPoolLocals::~ObjectPoolLocals() {
+    exiting() = true;
+    std::lock_guard<std::mutex> lock(ObjectPoolCore::registryMutex());
+    for(ObjectPoolLocal &e: entries) {
+        if(ObjectPoolCore::registry().count(e.id) != 0) {
+            e.core->spill(e,e.count);
+            e.core->hits_.fetch_add(e.hits,std::memory_order_relaxed);
+        }
+    }
+    entries.clear();
+}
+
+template<class T>
+class ObjectPool {
+public:
+    // allocateShared 用的分配器：控制块 (里面嵌着对象) 从 blocks_ 里分配
+    template<class U>
+    struct Allocator {
+        using value_type = U;
+        ObjectPool *pool;
+
+        explicit Allocator(ObjectPool *p) noexcept:pool(p) {}
+        template<class V>
+        Allocator(Allocator<V> const &that) noexcept:pool(that.pool) {}
+
+        U *allocate(std::size_t n) {
+            if(n == 1 && sizeof(U) <= pool->blockSize()) {
+                return static_cast<U *>(pool->blocks_.allocate());
+            }
+            return static_cast<U *>(::operator new(n * sizeof(U),std::align_val_t(alignof(U))));
+        }
+        void deallocate(U *ptr,std::size_t n) noexcept {
+            if(n == 1 && sizeof(U) <= pool->blockSize()) {
+                pool->blocks_.deallocate(ptr);
+                return;
+            }
+            ::operator delete(ptr,std::align_val_t(alignof(U)));
+        }
+        template<class V>
+        bool operator==(Allocator<V> const &that) const noexcept {
+            return pool == that.pool;
+        }
+    };
+
+    using Handle = UniquePtr<T,PoolDeleter<T,ObjectPool> >;
+    using Block = SpControlBlockImplAlloc<T,Allocator<T>,SpAtomicPolicy>;
+
+private:
+    ObjectPoolCore objects_{sizeof(T),alignof(T)};
+    ObjectPoolCore blocks_{sizeof(Block),alignof(Block)};
+
+    static constexpr std::size_t blockSize() noexcept {
+        return sizeof(Block);
+    }
+
+public:
+    ObjectPool() = default;
+    ObjectPool(ObjectPool &&) = delete;
+
+    void *allocate() {
+        return objects_.allocate();
+    }
+    void deallocate(void *ptr) noexcept {
+        objects_.deallocate(ptr);
+    }
+
+    // 析构时通过 PoolDeleter 把内存还给池子
+    template<class...Args>
+    Handle make(Args&&...args) {
+        void *mem = allocate();
+        T *obj;
+        try {
+            obj = new (mem) T(std::forward<Args>(args)...);
+        }catch(...) {
+            deallocate(mem);
+            throw;
+        }
+        return Handle(obj,PoolDeleter<T,ObjectPool>(this));
+    }
+
+    // 控制块和对象在同一个池化的节点里，最后一个 SharedPtr/WeakPtr 离开时还给池子
+    template<class...Args>
+    SharedPtr<T> makeShared(Args&&...args) {
+        return allocateShared<T>(Allocator<T>(this),std::forward<Args>(args)...);
+    }
+
+    void flushLocal() noexcept {
+        objects_.flushLocal();
+        blocks_.flushLocal();
+    }
+
+    // 两种句柄的统计之和
+    ObjectPoolStats stats() {
+        ObjectPoolStats a = objects_.stats();
+        ObjectPoolStats b = blocks_.stats();
+        return {a.hits + b.hits,a.misses + b.misses,a.highWater + b.highWater};
+    }
+};
+
+#endif //OBJECT_POOL_HPP
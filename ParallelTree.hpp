@@ -0,0 +1,153 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 基于 _RbTreeImpl 的并行遍历与归约
+/*
+ * 1. 在靠近根的位置把树切成按中序排列、互不相交的任务 (见 _RbTreeImpl::_M_split)
+ * 2. 任务数取线程数的若干倍，线程从共享游标上领取任务，先做完的线程继续领取，负载自然均衡
+ * 3. 归约时每个任务只产生一个局部结果，最后按任务顺序合并，所以只要求 __op 满足结合律
+ * 4. parallel_reduce 对 Map 归约的是 value (pair 的 second)，对 Set 归约的是元素本身
+ */
+#ifndef PARALLEL_TREE_HPP
+#define PARALLEL_TREE_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "RbTree.hpp"
+
+// 并行遍历用到的辅助函数
+struct _ParallelTreeBase {
+    // 每个线程平均分到的任务数，越大越均衡，但切分和合并的开销也越大
+    static constexpr unsigned _S_tasks_per_thread = 8;
+
+    static unsigned _S_default_threads() noexcept {
+        unsigned __n = std::thread::hardware_concurrency();
+        return __n == 0 ? 1 : __n;
+    }
+
+    static unsigned _S_split_depth(unsigned __threads) noexcept {
+        unsigned __depth = 0;
+        while ((std::size_t(1) << __depth) < std::size_t(__threads) * _S_tasks_per_thread) {
+            ++__depth;
+        }
+        return __depth;
+    }
+
+    // 在 __threads 个线程 (含调用线程) 上执行 __task(0..__count-1)，任务抛出的第一个异常会被重新抛出
+    template<class _Task>
+    static void _S_run(std::size_t __count, unsigned __threads, _Task &__task) {
+        if (__count == 0) {
+            return;
+        }
+        std::atomic<std::size_t> __cursor{0};
+        std::exception_ptr __error;
+        std::mutex __error_mutex;
+        auto __worker = [&] {
+            std::size_t __i;
+            while ((__i = __cursor.fetch_add(1, std::memory_order_relaxed)) < __count) {
+                try {
+                    __task(__i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> __lock(__error_mutex);
+                    if (!__error) {
+                        __error = std::current_exception();
+                    }
+                    __cursor.store(__count, std::memory_order_relaxed); // 放弃剩下的任务
+                }
+            }
+        };
+        std::vector<std::thread> __pool;
+        unsigned __extra = static_cast<unsigned>(std::min<std::size_t>(__threads, __count)) - 1;
+        __pool.reserve(__extra);
+        for (unsigned __t = 0; __t < __extra; ++__t) {
+            __pool.emplace_back(__worker);
+        }
+        __worker();
+        for (std::thread &__th: __pool) {
+            __th.join();
+        }
+        if (__error) {
+            std::rethrow_exception(__error);
+        }
+    }
+};
+
+// 对每个元素调用 __f，元素之间没有顺序保证，__f 需要自行保证线程安全
+template<class _Tree, class _Fn>
+void parallel_for_each(_Tree &__tree, _Fn __f, unsigned __threads = _ParallelTreeBase::_S_default_threads()) {
+    auto __visit = [&__f](auto &__value) {
+        if constexpr (std::is_const_v<_Tree>) {
+            __f(std::as_const(__value));
+        } else {
+            __f(__value);
+        }
+    };
+    if (__threads <= 1) {
+        for (_RbTreeChunk __chunk: __tree._M_split(0)) {
+            __tree._M_chunk_for_each(__chunk, __visit);
+        }
+        return;
+    }
+    std::vector<_RbTreeChunk> __chunks = __tree._M_split(_ParallelTreeBase::_S_split_depth(__threads));
+    auto __task = [&](std::size_t __i) {
+        __tree._M_chunk_for_each(__chunks[__i], __visit);
+    };
+    _ParallelTreeBase::_S_run(__chunks.size(), __threads, __task);
+}
+
+// 按 key 的顺序计算 __init op t(e0) op t(e1) op ...，__op 只需满足结合律，不需要交换律
+template<class _Tree, class _Tp, class _BinaryOp, class _UnaryOp>
+_Tp parallel_transform_reduce(_Tree const &__tree, _Tp __init, _BinaryOp __op, _UnaryOp __transform,
+                              unsigned __threads = _ParallelTreeBase::_S_default_threads()) {
+    std::vector<_RbTreeChunk> __chunks =
+            __tree._M_split(__threads <= 1 ? 0 : _ParallelTreeBase::_S_split_depth(__threads));
+    std::vector<std::optional<_Tp> > __partials(__chunks.size());
+    auto __task = [&](std::size_t __i) {
+        std::optional<_Tp> &__acc = __partials[__i];
+        auto __fold = [&](auto const &__value) {
+            if (__acc) {
+                __acc = __op(std::move(*__acc), __transform(__value));
+            } else {
+                __acc.emplace(__transform(__value));
+            }
+        };
+        __tree._M_chunk_for_each(__chunks[__i], __fold);
+    };
+    if (__threads <= 1) {
+        for (std::size_t __i = 0; __i < __chunks.size(); ++__i) {
+            __task(__i);
+        }
+    } else {
+        _ParallelTreeBase::_S_run(__chunks.size(), __threads, __task);
+    }
+    for (std::optional<_Tp> &__partial: __partials) {
+        if (__partial) {
+            __init = __op(std::move(__init), std::move(*__partial));
+        }
+    }
+    return __init;
+}
+
+// 有 mapped_type 的树 (Map) 归约每个元素的 second，其余的树归约元素本身
+template<class _Tree, class _Tp, class _BinaryOp = std::plus<> >
+_Tp parallel_reduce(_Tree const &__tree, _Tp __init, _BinaryOp __op = _BinaryOp(),
+                    unsigned __threads = _ParallelTreeBase::_S_default_threads()) {
+    auto __project = [](auto const &__value) -> _Tp {
+        if constexpr (requires { typename _Tree::mapped_type; }) {
+            return __value.second;
+        } else {
+            return __value;
+        }
+    };
+    return parallel_transform_reduce(__tree, std::move(__init), std::move(__op), __project, __threads);
+}
+
+#endif //PARALLEL_TREE_HPP
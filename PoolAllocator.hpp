@@ -0,0 +1,198 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 线程本地的定长内存池分配器，用于 allocateShared 等大量分配同一大小对象的场景
+/*
+ * 1. 每种 (大小, 对齐) 在每个线程上有一条空闲链表，allocate(1) 先从本线程的链表上取
+ * 2. deallocate 放回当前线程的链表，由别的线程释放的块就留在那个线程里复用
+ * 3. 链表长度有上限，超出的块直接还给 ::operator delete，线程退出时整条链表归还
+ * 4. FreeListPool 是单线程的对象池，配合 PoolDeleter 让 UniquePtr 把对象还给池子而不是 delete
+ */
+#ifndef POOL_ALLOCATOR_HPP
+#define POOL_ALLOCATOR_HPP
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+#include "SmartPtr.hpp"
+
+template<std::size_t Size,std::size_t Align>
+struct ThreadLocalFreeList {
+private:
+    union Node {
+        Node *next;
+        alignas(Align) unsigned char storage[Size];
+    };
+
+    // 没有析构函数，线程退出过程中任何时候都可以读写
+    struct State {
+        Node *head;
+        std::size_t count;
+        bool registered;    // 本线程的 Cleanup 已经构造
+        bool exiting;       // Cleanup 已经析构，之后的 push 直接释放
+    };
+
+    // 线程退出时归还整条链表；其它 thread_local 对象可能晚于它析构，所以状态不放在这里
+    struct Cleanup {
+        ~Cleanup() {
+            State &s = state();
+            while(s.head != nullptr) {
+                Node *next = s.head->next;
+                ::operator delete(s.head,std::align_val_t(alignof(Node)));
+                s.head = next;
+            }
+            s.count = 0;
+            s.exiting = true;
+        }
+    };
+
+    static State &state() noexcept {
+        static thread_local State s{};
+        return s;
+    }
+
+public:
+    static constexpr std::size_t kMaxCached = 4096;
+
+    ThreadLocalFreeList() = delete;
+
+    static void *pop() {
+        State &s = state();
+        if(s.head == nullptr) {
+            return ::operator new(sizeof(Node),std::align_val_t(alignof(Node)));
+        }
+        Node *node = s.head;
+        s.head = node->next;
+        --s.count;
+        return node;
+    }
+
+    static void push(void *ptr) noexcept {
+        State &s = state();
+        if(s.exiting || s.count >= kMaxCached) {
+            ::operator delete(ptr,std::align_val_t(alignof(Node)));
+            return;
+        }
+        if(!s.registered) {
+            static thread_local Cleanup cleanup;
+            s.registered = true;
+        }
+        Node *node = static_cast<Node *>(ptr);
+        node->next = s.head;
+        s.head = node;
+        ++s.count;
+    }
+};
+
+// 无状态的分配器，所有实例都相等；只有 allocate(1) 走内存池，数组分配直接使用 ::operator new
+template<class T>
+struct ThreadLocalPoolAllocator {
+    using value_type = T;
+    using FreeList = ThreadLocalFreeList<sizeof(T),alignof(T)>;
+
+    ThreadLocalPoolAllocator() noexcept = default;
+    template<class U>
+    ThreadLocalPoolAllocator(ThreadLocalPoolAllocator<U> const &) noexcept {}
+
+    T *allocate(std::size_t n) {
+        if(n == 1) {
+            return static_cast<T *>(FreeList::pop());
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T),std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T *ptr,std::size_t n) noexcept {
+        if(n == 1) {
+            FreeList::push(ptr);
+            return;
+        }
+        ::operator delete(ptr,std::align_val_t(alignof(T)));
+    }
+
+    template<class U>
+    bool operator==(ThreadLocalPoolAllocator<U> const &) const noexcept {
+        return true;
+    }
+};
+
+template<class T>
+struct FreeListPool;
+
+// 析构对象并把内存还给 Pool；Pool 需要提供 deallocate(void *)
+template<class T,class Pool = FreeListPool<T> >
+struct PoolDeleter {
+    Pool *pool = nullptr;
+
+    PoolDeleter() noexcept = default;
+    explicit PoolDeleter(Pool *p) noexcept:pool(p) {}
+
+    void operator()(T *ptr) const noexcept {
+        ptr->~T();
+        pool->deallocate(ptr);
+    }
+};
+
+// 单线程的对象池：按 kChunk 个一组成批向系统申请，空闲块串成链表，池子析构时才归还系统
+// 池子必须比它分出去的所有对象活得久
+template<class T>
+struct FreeListPool {
+private:
+    union Node {
+        Node *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    Node *head_ = nullptr;
+    std::vector<Node *> chunks_;
+
+    void grow() {
+        chunks_.reserve(chunks_.size() + 1);
+        auto *chunk = static_cast<Node *>(::operator new(sizeof(Node) * kChunk,std::align_val_t(alignof(Node))));
+        chunks_.push_back(chunk);
+        for(std::size_t i = kChunk; i-- > 0;) {
+            chunk[i].next = head_;
+            head_ = chunk + i;
+        }
+    }
+
+public:
+    using Handle = UniquePtr<T,PoolDeleter<T,FreeListPool> >;
+    static constexpr std::size_t kChunk = 64;
+
+    FreeListPool() = default;
+    FreeListPool(FreeListPool &&) = delete;
+
+    ~FreeListPool() {
+        for(Node *chunk: chunks_) {
+            ::operator delete(chunk,std::align_val_t(alignof(Node)));
+        }
+    }
+
+    void *allocate() {
+        if(head_ == nullptr) {
+            grow();
+        }
+        return std::exchange(head_,head_->next);
+    }
+
+    void deallocate(void *ptr) noexcept {
+        Node *node = static_cast<Node *>(ptr);
+        node->next = head_;
+        head_ = node;
+    }
+
+    template<class...Args>
+    Handle make(Args&&...args) {
+        void *mem = allocate();
+        T *obj;
+        try {
+            obj = new (mem) T(std::forward<Args>(args)...);
+        }catch(...) {
+            deallocate(mem);
+            throw;
+        }
+        return Handle(obj,PoolDeleter<T,FreeListPool>(this));
+    }
+};
+
+#endif //POOL_ALLOCATOR_HPP
@@ -4,11 +4,14 @@
 
 #ifndef RBTREE_HPP
 #define RBTREE_HPP
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <iterator>
 #include <memory>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #include "Common.hpp"
 
 enum _RbTreeColor {
@@ -29,9 +32,17 @@ struct _RbTreeNode {
     _RbTreeColor _M_color; // 红或黑
 };
 
-// 带上实际的数据类型
-template<class _Tp>
-struct _RbTreeNodeImpl : _RbTreeNode {
+// 线索化节点：额外维护中序意义上的前驱和后继，迭代器 ++/-- 只需一次指针读取
+struct _RbTreeThreadedNode : _RbTreeNode {
+    _RbTreeNode *_M_prev; // 中序前驱，最小节点为 nullptr
+    _RbTreeNode *_M_next; // 中序后继，最大节点为 nullptr
+};
+
+// 带上实际的数据类型，_Base 决定是否带前驱后继链表
+template<class _Tp, class _Base = _RbTreeNode>
+struct _RbTreeNodeImpl : _Base {
+    static constexpr bool _S_threaded = std::is_base_of_v<_RbTreeThreadedNode, _Base>;
+
     union {
         _Tp _M_value;
     }; // union 可以阻止里面成员的自动初始化，方便不支持 _Tp() 默认构造的类型
@@ -53,6 +64,10 @@ struct _RbTreeNodeImpl : _RbTreeNode {
     }
 };
 
+// 作为 _RbTreeImpl 的 _NodeImpl 参数使用，以每个节点两个指针的代价换取 O(1) 的迭代器移动
+template<class _Tp>
+using _RbTreeThreadedNodeImpl = _RbTreeNodeImpl<_Tp, _RbTreeThreadedNode>;
+
 // 声明一个模板结构体 _RbTreeIteratorBase，用于红黑树的迭代器基础
 template<bool>
 struct _RbTreeIteratorBase;
@@ -159,6 +174,40 @@ public:
             _M_node = _M_node->_M_parent;
         }
     }
+
+    // 线索化节点的前缀自增，状态的约定与 operator++ 相同
+    void _M_threaded_increment() noexcept {
+        if (status == ENDOFF) {
+            return;
+        }
+        if (status == BEGINOFF) {
+            status = NORMAL;
+            return;
+        }
+        _RbTreeNode *__next = static_cast<_RbTreeThreadedNode *>(_M_node)->_M_next;
+        if (__next == nullptr) {
+            status = ENDOFF; // node 保持指向最大的节点
+        } else {
+            _M_node = __next;
+        }
+    }
+
+    // 线索化节点的前缀自减，状态的约定与 operator-- 相同
+    void _M_threaded_decrement() noexcept {
+        if (status == BEGINOFF) {
+            return;
+        }
+        if (status == ENDOFF) {
+            status = NORMAL;
+            return;
+        }
+        _RbTreeNode *__prev = static_cast<_RbTreeThreadedNode *>(_M_node)->_M_prev;
+        if (__prev == nullptr) {
+            status = BEGINOFF; // node 保持指向最小的节点
+        } else {
+            _M_node = __prev;
+        }
+    }
 };
 
 // 定义当模板参数为 true 时的 _RbTreeIteratorBase 结构体，继承自 _RbTreeIteratorBase<false>
@@ -189,25 +238,37 @@ public:
     template<class T0 = _Tp>
     explicit operator std::enable_if_t<std::is_const_v<T0>,
         _RbTreeIterator<_NodeImpl, std::remove_const_t<T0>, _Reverse> >() const noexcept {
-        return _RbTreeIterator<_NodeImpl, T0, _Reverse>(this->node, this->status);
+        return _RbTreeIterator<_NodeImpl, std::remove_const_t<T0>, _Reverse>(this->_M_node, this->status);
     }
 
     // non const -> const
     template<class T0 = _Tp>
     operator std::enable_if_t<!std::is_const_v<T0>,
         _RbTreeIterator<_NodeImpl, std::add_const_t<T0>, _Reverse> >() const noexcept {
-        return _RbTreeIterator<_NodeImpl, std::add_const_t<T0>, _Reverse>(this->node, this->status);
+        return _RbTreeIterator<_NodeImpl, std::add_const_t<T0>, _Reverse>(this->_M_node, this->status);
     }
 
     _RbTreeIterator &operator++() noexcept {
         // ++__it
-        _RbTreeIteratorBase<_Reverse>::operator++();
+        if constexpr (!_NodeImpl::_S_threaded) {
+            _RbTreeIteratorBase<_Reverse>::operator++();
+        } else if constexpr (_Reverse) {
+            this->_M_threaded_decrement();
+        } else {
+            this->_M_threaded_increment();
+        }
         return *this;
     }
 
     _RbTreeIterator &operator--() noexcept {
         // --__it
-        _RbTreeIteratorBase<_Reverse>::operator--();
+        if constexpr (!_NodeImpl::_S_threaded) {
+            _RbTreeIteratorBase<_Reverse>::operator--();
+        } else if constexpr (_Reverse) {
+            this->_M_threaded_increment();
+        } else {
+            this->_M_threaded_decrement();
+        }
         return *this;
     }
 
@@ -243,6 +304,63 @@ struct _RbTreeRoot {
     _RbTreeNode *_M_root;
 };
 
+// 并行遍历时的任务单元：切口以下的一整棵子树，或者切口以上的单个节点
+struct _RbTreeChunk {
+    _RbTreeNode *_M_node;
+    bool _M_subtree;
+};
+
+// _RbTreeImpl 的统计策略，默认的 _RbTreeNoStats 只有空函数，关闭时不留下任何计数代码
+struct _RbTreeNoStats {
+    static constexpr bool _S_enabled = false;
+
+    void _M_on_compare() noexcept {}
+    void _M_on_rotate_left() noexcept {}
+    void _M_on_rotate_right() noexcept {}
+    void _M_on_fix_violation() noexcept {}
+    void _M_on_delete_fixup() noexcept {}
+    void _M_on_allocate() noexcept {}
+    void _M_on_deallocate() noexcept {}
+    void _M_on_depth(std::size_t) noexcept {}
+};
+
+// 计数版本：比较器调用、左右旋转、插入/删除修复的循环次数、节点的分配和释放、插入时到达的最大深度 (根为 1)
+// 计数是普通整数，打开统计后即使只读的查找也会写计数，不能再由多个线程同时读同一棵树
+struct _RbTreeStats {
+    static constexpr bool _S_enabled = true;
+
+    std::size_t comparisons = 0;
+    std::size_t rotate_left = 0;
+    std::size_t rotate_right = 0;
+    std::size_t fix_violation_steps = 0;
+    std::size_t delete_fixup_steps = 0;
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t max_depth = 0;
+
+    void _M_on_compare() noexcept { ++comparisons; }
+    void _M_on_rotate_left() noexcept { ++rotate_left; }
+    void _M_on_rotate_right() noexcept { ++rotate_right; }
+    void _M_on_fix_violation() noexcept { ++fix_violation_steps; }
+    void _M_on_delete_fixup() noexcept { ++delete_fixup_steps; }
+    void _M_on_allocate() noexcept { ++allocations; }
+    void _M_on_deallocate() noexcept { ++deallocations; }
+    void _M_on_depth(std::size_t __depth) noexcept { max_depth = std::max(max_depth, __depth); }
+};
+
+// 打开统计时代替 _Compare 传给查找和插入，每次调用先计数
+template<class _Compare, class _Stats>
+struct _RbTreeCountingCompare {
+    _Compare _M_comp;
+    _Stats *_M_stats;
+
+    template<class _Lhs, class _Rhs>
+    bool operator()(_Lhs const &__lhs, _Rhs const &__rhs) {
+        _M_stats->_M_on_compare();
+        return _M_comp(__lhs, __rhs);
+    }
+};
+
 struct _RbTreeBase {
 protected:
     template<class _Tp, class _Compare, class _Alloc, class _NodeImpl,
@@ -258,7 +376,7 @@ protected:
         typename std::allocator_traits<_Alloc>::template rebind_alloc<_Type>
                 __rebind_alloc(__alloc);
         return std::allocator_traits<_Alloc>::template rebind_traits<
-            _Type>::allocate(__rebind_alloc, sizeof(_Type));
+            _Type>::allocate(__rebind_alloc, 1);
     }
 
     template<class _Type, class _Alloc>
@@ -266,11 +384,12 @@ protected:
         typename std::allocator_traits<_Alloc>::template rebind_alloc<_Type>
                 __rebind_alloc(__alloc);
         std::allocator_traits<_Alloc>::template rebind_traits<
-            _Type>::deallocate(__rebind_alloc, static_cast<_Type *>(__ptr),
-                               sizeof(_Type));
+            _Type>::deallocate(__rebind_alloc, static_cast<_Type *>(__ptr), 1);
     }
 
-    static void _M_rotate_left(_RbTreeNode *__node) noexcept {
+    template<class _Stats>
+    static void _M_rotate_left(_RbTreeNode *__node, _Stats &__stats) noexcept {
+        __stats._M_on_rotate_left();
         _RbTreeNode *__right = __node->_M_right;
         __node->_M_right = __right->_M_left;
         if (__right->_M_left != nullptr) {
@@ -285,7 +404,9 @@ protected:
         __node->_M_pparent = &__right->_M_left;
     }
 
-    static void _M_rotate_right(_RbTreeNode *__node) noexcept {
+    template<class _Stats>
+    static void _M_rotate_right(_RbTreeNode *__node, _Stats &__stats) noexcept {
+        __stats._M_on_rotate_right();
         _RbTreeNode *__left = __node->_M_left;
         __node->_M_left = __left->_M_right;
         if (__left->_M_right != nullptr) {
@@ -300,8 +421,10 @@ protected:
         __node->_M_pparent = &__left->_M_right;
     }
 
-    static void _M_fix_violation(_RbTreeNode *__node) noexcept {
+    template<class _Stats>
+    static void _M_fix_violation(_RbTreeNode *__node, _Stats &__stats) noexcept {
         while (true) {
+            __stats._M_on_fix_violation();
             _RbTreeNode *__parent = __node->_M_parent;
             if (__parent == nullptr) {
                 // 根节点的 __parent 总是 nullptr
@@ -338,10 +461,10 @@ protected:
                 if (__node_dir == _S_right) {
                     assert(__node->_M_pparent == &__parent->_M_right);
                     // 情况 2: 叔叔是黑色人士（RR）
-                    _RbTreeBase::_M_rotate_left(__grandpa);
+                    _RbTreeBase::_M_rotate_left(__grandpa, __stats);
                 } else {
                     // 情况 3: 叔叔是黑色人士（LL）
-                    _RbTreeBase::_M_rotate_right(__grandpa);
+                    _RbTreeBase::_M_rotate_right(__grandpa, __stats);
                 }
                 std::swap(__parent->_M_color, __grandpa->_M_color);
                 __node = __grandpa;
@@ -349,10 +472,10 @@ protected:
                 if (__node_dir == _S_right) {
                     assert(__node->_M_pparent == &__parent->_M_right);
                     // 情况 4: 叔叔是黑色人士（LR）
-                    _RbTreeBase::_M_rotate_left(__parent);
+                    _RbTreeBase::_M_rotate_left(__parent, __stats);
                 } else {
                     // 情况 5: 叔叔是黑色人士（RL）
-                    _RbTreeBase::_M_rotate_right(__parent);
+                    _RbTreeBase::_M_rotate_right(__parent, __stats);
                 }
                 __node = __parent;
             }
@@ -443,6 +566,45 @@ protected:
         };
     }
 
+    // 在离根 __depth 层的位置把树切开，按中序输出各个任务单元
+    static void _M_split_chunks(_RbTreeNode *__node, unsigned __depth,
+                                std::vector<_RbTreeChunk> &__chunks) {
+        if (__node == nullptr) {
+            return;
+        }
+        if (__depth == 0) {
+            __chunks.push_back({__node, true});
+            return;
+        }
+        _RbTreeBase::_M_split_chunks(__node->_M_left, __depth - 1, __chunks);
+        __chunks.push_back({__node, false});
+        _RbTreeBase::_M_split_chunks(__node->_M_right, __depth - 1, __chunks);
+    }
+
+    // 红黑树高度不超过 2*log2(n+1)，64 位地址空间下 128 层足够
+    static constexpr std::size_t _S_max_height = 128;
+
+    // 中序遍历一棵子树：用显式栈代替迭代器的父指针回溯，每一步没有状态判断
+    template<class _NodeImpl, class _Fn>
+    static void _M_subtree_for_each(_RbTreeNode *__node, _Fn &__f) {
+        _RbTreeNode *__stack[_S_max_height];
+        std::size_t __top = 0;
+        while (true) {
+            while (__node != nullptr) {
+                __stack[__top++] = __node;
+                __node = __node->_M_left;
+            }
+            if (__top == 0) {
+                return;
+            }
+            __node = __stack[--__top];
+            // 下一步要进入右子树，在调用 __f 期间把它取进缓存
+            _LIBPENGCXX_PREFETCH(__node->_M_right);
+            __f(static_cast<_NodeImpl *>(__node)->_M_value);
+            __node = __node->_M_right;
+        }
+    }
+
     /**
      * 在红黑树中用另一节点替换当前节点。
      *
@@ -464,95 +626,137 @@ protected:
         }
     }
 
-    static void _M_delete_fixup(_RbTreeNode *__node) noexcept {
-        if (__node == nullptr) {
+    // 新插入的叶子挂在 __parent 下，它的前驱后继可以直接从 __parent 得到
+    static void _M_thread_link(_RbTreeNode *__node, _RbTreeNode *__parent) noexcept {
+        auto *__tnode = static_cast<_RbTreeThreadedNode *>(__node);
+        if (__parent == nullptr) {
+            __tnode->_M_prev = nullptr;
+            __tnode->_M_next = nullptr;
             return;
         }
-        while (__node->_M_parent != nullptr && __node->_M_color == _S_black) {
-            _RbTreeChildDir __dir =
-                    __node->_M_pparent == &__node->_M_parent->_M_left
-                        ? _S_left
-                        : _S_right;
-            _RbTreeNode *__sibling = __dir == _S_left
-                                         ? __node->_M_parent->_M_right
-                                         : __node->_M_parent->_M_left;
-            if (__sibling->_M_color == _S_red) {
-                __sibling->_M_color = _S_black;
-                __node->_M_parent->_M_color = _S_red;
-                if (__dir == _S_left) {
-                    _RbTreeBase::_M_rotate_left(__node->_M_parent);
-                } else {
-                    _RbTreeBase::_M_rotate_right(__node->_M_parent);
+        auto *__tparent = static_cast<_RbTreeThreadedNode *>(__parent);
+        if (__node == __parent->_M_left) {
+            __tnode->_M_prev = __tparent->_M_prev;
+            __tnode->_M_next = __parent;
+            __tparent->_M_prev = __node;
+        } else {
+            __tnode->_M_prev = __parent;
+            __tnode->_M_next = __tparent->_M_next;
+            __tparent->_M_next = __node;
+        }
+        if (__tnode->_M_prev != nullptr) {
+            static_cast<_RbTreeThreadedNode *>(__tnode->_M_prev)->_M_next = __node;
+        }
+        if (__tnode->_M_next != nullptr) {
+            static_cast<_RbTreeThreadedNode *>(__tnode->_M_next)->_M_prev = __node;
+        }
+    }
+
+    // 旋转和顶替都不改变中序，删除时只需把节点从链表中摘掉
+    static void _M_thread_unlink(_RbTreeNode *__node) noexcept {
+        auto *__tnode = static_cast<_RbTreeThreadedNode *>(__node);
+        if (__tnode->_M_prev != nullptr) {
+            static_cast<_RbTreeThreadedNode *>(__tnode->_M_prev)->_M_next = __tnode->_M_next;
+        }
+        if (__tnode->_M_next != nullptr) {
+            static_cast<_RbTreeThreadedNode *>(__tnode->_M_next)->_M_prev = __tnode->_M_prev;
+        }
+    }
+
+    static bool _M_is_black(_RbTreeNode *__node) noexcept {
+        return __node == nullptr || __node->_M_color == _S_black; // 叶子节点 (NULL) 视为黑色
+    }
+
+    // __node 可能为 NULL，所以需要额外传入它的父节点
+    template<class _Stats>
+    static void _M_delete_fixup(_RbTreeNode *__node, _RbTreeNode *__parent, _Stats &__stats) noexcept {
+        while (__parent != nullptr && _RbTreeBase::_M_is_black(__node)) {
+            __stats._M_on_delete_fixup();
+            if (__node == __parent->_M_left) {
+                _RbTreeNode *__sibling = __parent->_M_right;
+                if (__sibling->_M_color == _S_red) {
+                    __sibling->_M_color = _S_black;
+                    __parent->_M_color = _S_red;
+                    _RbTreeBase::_M_rotate_left(__parent, __stats);
+                    __sibling = __parent->_M_right;
                 }
-                __sibling = __dir == _S_left
-                                ? __node->_M_parent->_M_right
-                                : __node->_M_parent->_M_left;
-            }
-            if (__sibling->_M_left->_M_color == _S_black &&
-                __sibling->_M_right->_M_color == _S_black) {
-                __sibling->_M_color = _S_red;
-                __node = __node->_M_parent;
-            } else {
-                if (__dir == _S_left &&
-                    __sibling->_M_right->_M_color == _S_black) {
+                if (_RbTreeBase::_M_is_black(__sibling->_M_left) &&
+                    _RbTreeBase::_M_is_black(__sibling->_M_right)) {
+                    __sibling->_M_color = _S_red;
+                    __node = __parent;
+                    __parent = __node->_M_parent;
+                    continue;
+                }
+                if (_RbTreeBase::_M_is_black(__sibling->_M_right)) {
                     __sibling->_M_left->_M_color = _S_black;
                     __sibling->_M_color = _S_red;
-                    _RbTreeBase::_M_rotate_right(__sibling);
-                    __sibling = __node->_M_parent->_M_right;
-                } else if (__dir == _S_right &&
-                           __sibling->_M_left->_M_color == _S_black) {
-                    __sibling->_M_right->_M_color = _S_black;
+                    _RbTreeBase::_M_rotate_right(__sibling, __stats);
+                    __sibling = __parent->_M_right;
+                }
+                __sibling->_M_color = __parent->_M_color;
+                __parent->_M_color = _S_black;
+                __sibling->_M_right->_M_color = _S_black;
+                _RbTreeBase::_M_rotate_left(__parent, __stats);
+            } else {
+                _RbTreeNode *__sibling = __parent->_M_left;
+                if (__sibling->_M_color == _S_red) {
+                    __sibling->_M_color = _S_black;
+                    __parent->_M_color = _S_red;
+                    _RbTreeBase::_M_rotate_right(__parent, __stats);
+                    __sibling = __parent->_M_left;
+                }
+                if (_RbTreeBase::_M_is_black(__sibling->_M_left) &&
+                    _RbTreeBase::_M_is_black(__sibling->_M_right)) {
                     __sibling->_M_color = _S_red;
-                    _RbTreeBase::_M_rotate_left(__sibling);
-                    __sibling = __node->_M_parent->_M_left;
+                    __node = __parent;
+                    __parent = __node->_M_parent;
+                    continue;
                 }
-                __sibling->_M_color = __node->_M_parent->_M_color;
-                __node->_M_parent->_M_color = _S_black;
-                if (__dir == _S_left) {
+                if (_RbTreeBase::_M_is_black(__sibling->_M_left)) {
                     __sibling->_M_right->_M_color = _S_black;
-                    _RbTreeBase::_M_rotate_left(__node->_M_parent);
-                } else {
-                    __sibling->_M_left->_M_color = _S_black;
-                    _RbTreeBase::_M_rotate_right(__node->_M_parent);
+                    __sibling->_M_color = _S_red;
+                    _RbTreeBase::_M_rotate_left(__sibling, __stats);
+                    __sibling = __parent->_M_left;
                 }
-                // while (__node->_M_parent != nullptr) {
-                //     __node = __node->_M_parent;
-                // }
-                break;
+                __sibling->_M_color = __parent->_M_color;
+                __parent->_M_color = _S_black;
+                __sibling->_M_left->_M_color = _S_black;
+                _RbTreeBase::_M_rotate_right(__parent, __stats);
             }
+            return;
+        }
+        if (__node != nullptr) {
+            __node->_M_color = _S_black;
         }
-        __node->_M_color = _S_black;
     }
 
-    static void _M_erase_node(_RbTreeNode *__node) noexcept {
+    template<class _Stats>
+    static void _M_erase_node(_RbTreeNode *__node, _Stats &__stats) noexcept {
+        _RbTreeNode *__child;
+        _RbTreeNode *__child_parent;
+        _RbTreeColor __color;
         if (__node->_M_left == nullptr) {
-            _RbTreeNode *__right = __node->_M_right;
-            _RbTreeColor __color = __node->_M_color;
-            _RbTreeBase::_M_transplant(__node, __right);
-            if (__color == _S_black) {
-                _RbTreeBase::_M_delete_fixup(__right);
-            }
+            __child = __node->_M_right;
+            __child_parent = __node->_M_parent;
+            __color = __node->_M_color;
+            _RbTreeBase::_M_transplant(__node, __child);
         } else if (__node->_M_right == nullptr) {
-            _RbTreeNode *__left = __node->_M_left;
-            _RbTreeColor __color = __node->_M_color;
-            _RbTreeBase::_M_transplant(__node, __left);
-            if (__color == _S_black) {
-                _RbTreeBase::_M_delete_fixup(__left);
-            }
+            __child = __node->_M_left;
+            __child_parent = __node->_M_parent;
+            __color = __node->_M_color;
+            _RbTreeBase::_M_transplant(__node, __child);
         } else {
             _RbTreeNode *__replace = __node->_M_right;
             while (__replace->_M_left != nullptr) {
                 __replace = __replace->_M_left;
             }
-            _RbTreeNode *__right = __replace->_M_right;
-            _RbTreeColor __color = __replace->_M_color;
+            __child = __replace->_M_right;
+            __color = __replace->_M_color;
             if (__replace->_M_parent == __node) {
-                if (__right != nullptr) {
-                    __right->_M_parent = __replace;
-                    __right->_M_pparent = &__replace->_M_right;
-                }
+                __child_parent = __replace;
             } else {
-                _RbTreeBase::_M_transplant(__replace, __right);
+                __child_parent = __replace->_M_parent;
+                _RbTreeBase::_M_transplant(__replace, __child);
                 __replace->_M_right = __node->_M_right;
                 __replace->_M_right->_M_parent = __replace;
                 __replace->_M_right->_M_pparent = &__replace->_M_right;
@@ -561,18 +765,21 @@ protected:
             __replace->_M_left = __node->_M_left;
             __replace->_M_left->_M_parent = __replace;
             __replace->_M_left->_M_pparent = &__replace->_M_left;
-            if (__color == _S_black) {
-                _RbTreeBase::_M_delete_fixup(__right);
-            }
+            __replace->_M_color = __node->_M_color; // 顶替者继承被删节点的颜色
+        }
+        if (__color == _S_black) {
+            _RbTreeBase::_M_delete_fixup(__child, __child_parent, __stats);
         }
     }
 
-    template<class _NodeImpl, class _Compare>
-    _RbTreeNode *_M_single_insert_node(_RbTreeNode *__node, _Compare __comp) {
+    template<class _NodeImpl, class _Compare, class _Stats>
+    _RbTreeNode *_M_single_insert_node(_RbTreeNode *__node, _Compare __comp, _Stats &__stats) {
         _RbTreeNode **__pparent = &_M_block->_M_root;
         _RbTreeNode *__parent = nullptr;
+        std::size_t __depth = 1;
         while (*__pparent != nullptr) {
             __parent = *__pparent;
+            ++__depth;
             if (__comp(static_cast<_NodeImpl *>(__node)->_M_value,
                        static_cast<_NodeImpl *>(__parent)->_M_value)) {
                 __pparent = &__parent->_M_left;
@@ -593,16 +800,22 @@ protected:
         __node->_M_parent = __parent;
         __node->_M_pparent = __pparent;
         *__pparent = __node;
-        _RbTreeBase::_M_fix_violation(__node);
+        if constexpr (_NodeImpl::_S_threaded) {
+            _RbTreeBase::_M_thread_link(__node, __parent);
+        }
+        __stats._M_on_depth(__depth);
+        _RbTreeBase::_M_fix_violation(__node, __stats);
         return nullptr;
     }
 
-    template<class _NodeImpl, class _Compare>
-    void _M_multi_insert_node(_RbTreeNode *__node, _Compare __comp) {
+    template<class _NodeImpl, class _Compare, class _Stats>
+    void _M_multi_insert_node(_RbTreeNode *__node, _Compare __comp, _Stats &__stats) {
         _RbTreeNode **__pparent = &_M_block->_M_root;
         _RbTreeNode *__parent = nullptr;
+        std::size_t __depth = 1;
         while (*__pparent != nullptr) {
             __parent = *__pparent;
+            ++__depth;
             if (__comp(static_cast<_NodeImpl *>(__node)->_M_value,
                        static_cast<_NodeImpl *>(__parent)->_M_value)) {
                 __pparent = &__parent->_M_left;
@@ -623,7 +836,11 @@ protected:
         __node->_M_parent = __parent;
         __node->_M_pparent = __pparent;
         *__pparent = __node;
-        _RbTreeBase::_M_fix_violation(__node);
+        if constexpr (_NodeImpl::_S_threaded) {
+            _RbTreeBase::_M_thread_link(__node, __parent);
+        }
+        __stats._M_on_depth(__depth);
+        _RbTreeBase::_M_fix_violation(__node, __stats);
     }
 };
 
@@ -654,7 +871,7 @@ protected:
     }
 
     // 友元声明，使_RbTreeImpl能够访问_RbTreeNodeHandle的保护成员
-    template<class, class, class, class>
+    template<class, class, class, class, class>
     friend struct _RbTreeImpl;
 
 public:
@@ -712,11 +929,32 @@ struct _RbTreeNodeHandle<
 
 
 template<class _Tp, class _Compare, class _Alloc,
-    class _NodeImpl = _RbTreeNodeImpl<_Tp> >
+    class _NodeImpl = _RbTreeNodeImpl<_Tp>, class _Stats = _RbTreeNoStats>
 struct _RbTreeImpl : protected _RbTreeBase {
 protected:
     [[no_unique_address]] _Alloc _M_alloc;
     [[no_unique_address]] _Compare _M_comp;
+    [[no_unique_address]] mutable _Stats _M_stats;
+
+    // 查找和插入用的比较器，打开统计时包一层计数
+    auto _M_key_comp() const noexcept {
+        if constexpr (_Stats::_S_enabled) {
+            return _RbTreeCountingCompare<_Compare, _Stats>{_M_comp, &_M_stats};
+        } else {
+            return _M_comp;
+        }
+    }
+
+    _NodeImpl *_M_allocate_node() {
+        _NodeImpl *__node = _RbTreeBase::_M_allocate<_NodeImpl>(_M_alloc);
+        _M_stats._M_on_allocate();
+        return __node;
+    }
+
+    void _M_deallocate_node(_RbTreeNode *__node) noexcept {
+        _M_stats._M_on_deallocate();
+        _RbTreeBase::_M_deallocate<_NodeImpl>(_M_alloc, __node);
+    }
 
 public:
     _RbTreeImpl() noexcept
@@ -756,10 +994,10 @@ protected:
     template <_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator, InputIt)>
     void _M_single_insert(InputIt input_iter) {
         // 调用父类的逻辑进行分配节点内存
-        auto node = _RbTreeBase::_M_allocate<_NodeImpl>(_M_alloc);
+        auto node = this->_M_allocate_node();
         // 在节点内构造对象
         node->_M_construct(*input_iter);
-        _RbTreeBase::_M_single_insert_node<_NodeImpl>(node,_M_comp);
+        _RbTreeBase::_M_single_insert_node<_NodeImpl>(node, this->_M_key_comp(), _M_stats);
     }
     template<_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator,
                                                     _InputIt)>
@@ -774,7 +1012,7 @@ protected:
                                                     _InputIt)>
     void _M_multi_insert(_InputIt __first, _InputIt __last) {
         while (__first != __last) {
-            this->_M_multi_insert(*__first);
+            this->_M_multi_emplace(*__first);
             ++__first;
         }
     }
@@ -795,41 +1033,58 @@ public:
 protected:
     template<class _Tv>
     const_iterator _M_find(_Tv &&__value) const noexcept {
-        auto node = this->_M_find_node<_NodeImpl>(__value, _M_comp);
+        auto node = this->_M_find_node<_NodeImpl>(__value, this->_M_key_comp());
         return node == nullptr ? end() : node;
     }
 
     template<class _Tv>
     iterator _M_find(_Tv &&__value) noexcept {
-        auto node = this->_M_find_node<_NodeImpl>(__value, _M_comp);
+        auto node = this->_M_find_node<_NodeImpl>(__value, this->_M_key_comp());
         return node == nullptr ? end() : node;
     }
 
     template<class... _Ts>
     iterator _M_multi_emplace(_Ts &&... __value) {
-        _NodeImpl *__node = _RbTreeBase::_M_allocate<_NodeImpl>(_M_alloc);
+        _NodeImpl *__node = this->_M_allocate_node();
         __node->_M_construct(std::forward<_Ts>(__value)...);
-        this->_M_multi_insert_node<_NodeImpl>(__node, _M_comp);
+        this->_M_multi_insert_node<_NodeImpl>(__node, this->_M_key_comp(), _M_stats);
         return __node;
     }
 
     template<class... _Ts>
     std::pair<iterator, bool> _M_single_emplace(_Ts &&... __value) {
-        _RbTreeNode *__node = _RbTreeBase::_M_allocate<_NodeImpl>(_M_alloc);
+        _RbTreeNode *__node = this->_M_allocate_node();
         static_cast<_NodeImpl *>(__node)->_M_construct(
             std::forward<_Ts>(__value)...);
         _RbTreeNode *__conflict =
-                this->_M_single_insert_node<_NodeImpl>(__node, _M_comp);
+                this->_M_single_insert_node<_NodeImpl>(__node, this->_M_key_comp(), _M_stats);
         if (__conflict) {
             static_cast<_NodeImpl *>(__node)->_M_destruct();
-            _RbTreeBase::_M_deallocate<_NodeImpl>(_M_alloc, __node);
+            this->_M_deallocate_node(__node);
             return {__conflict, false};
         } else {
             return {__node, true};
         }
     }
 
+    // 线索化节点在摘除前先离开前驱后继链表，其余节点类型与 _RbTreeBase 的版本相同
+    void _M_erase_node(_RbTreeNode *__node) noexcept {
+        if constexpr (_NodeImpl::_S_threaded) {
+            _RbTreeBase::_M_thread_unlink(__node);
+        }
+        _RbTreeBase::_M_erase_node(__node, _M_stats);
+    }
+
 public:
+    // 统计关闭时返回的是空的 _RbTreeNoStats
+    _Stats const &stats() const noexcept {
+        return _M_stats;
+    }
+
+    void reset_stats() noexcept {
+        _M_stats = _Stats();
+    }
+
     void clear() noexcept {
         iterator __it = this->begin();
         while (__it != this->end()) {
@@ -844,10 +1099,10 @@ public:
         _RbTreeNode *__node = __it._M_node;
         _RbTreeImpl::_M_erase_node(__node);
         static_cast<_NodeImpl *>(__node)->_M_destruct();
-        if(__node->_M_parent == nullptr && __node->_M_left == nullptr && __node->_M_right==nullptr)[[unlikely]] {
-            __tmp._M_node = nullptr;
+        this->_M_deallocate_node(__node);
+        if (__tmp.status == iterator::ENDOFF) {
+            return this->end(); // 删除的是最大节点，__tmp 仍指向它
         }
-        _RbTreeBase::_M_deallocate<_NodeImpl>(_M_alloc, __node);
         return __tmp;
     }
 
@@ -857,7 +1112,7 @@ public:
     std::pair<iterator, bool> insert(node_type __nh) {
         _NodeImpl *__node = __nh._M_node;
         _RbTreeNode *__conflict =
-                this->_M_single_insert_node<_NodeImpl>(__node, _M_comp);
+                this->_M_single_insert_node<_NodeImpl>(__node, this->_M_key_comp(), _M_stats);
         if (__conflict) {
             static_cast<_NodeImpl *>(__node)->_M_destruct();
             return {__conflict, false};
@@ -874,11 +1129,11 @@ protected:
     }
     template<class _Tv>
     size_t _M_single_erase(_Tv &&__value) noexcept {
-        _RbTreeNode *__node = this->_M_find_node<_NodeImpl>(__value, _M_comp);
+        _RbTreeNode *__node = this->_M_find_node<_NodeImpl>(__value, this->_M_key_comp());
         if (__node != nullptr) {
-            this->_M_erase_node(__node);
+            _RbTreeImpl::_M_erase_node(__node);
             static_cast<_NodeImpl *>(__node)->_M_destruct();
-            _RbTreeBase::_M_deallocate<_NodeImpl>(_M_alloc, __node);
+            this->_M_deallocate_node(__node);
             return 1;
         } else {
             return 0;
@@ -889,7 +1144,9 @@ protected:
                                                const_iterator __last) noexcept {
         size_t __num = 0;
         iterator __it(__first);
-        while (__it != __last) {
+        // end() 记录的是最大节点，删到最后它会变，所以每次重新取
+        bool __to_end = __last.status == const_iterator::ENDOFF;
+        while (__to_end ? __it != this->end() : __it != __last) {
             __it = this->erase(__it);
             ++__num;
         }
@@ -910,25 +1167,25 @@ public:
     template<class _Tv,
         _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
     iterator lower_bound(_Tv &&__value) noexcept {
-        return this->_M_lower_bound<_NodeImpl>(__value, _M_comp);
+        return this->_M_lower_bound<_NodeImpl>(__value, this->_M_key_comp());
     }
 
     template<class _Tv,
         _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
     const_iterator lower_bound(_Tv &&__value) const noexcept {
-        return this->_M_lower_bound<_NodeImpl>(__value, _M_comp);
+        return this->_M_lower_bound<_NodeImpl>(__value, this->_M_key_comp());
     }
 
     template<class _Tv,
         _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
     iterator upper_bound(_Tv &&__value) noexcept {
-        return this->_M_upper_bound<_NodeImpl>(__value, _M_comp);
+        return this->_M_upper_bound<_NodeImpl>(__value, this->_M_key_comp());
     }
 
     template<class _Tv,
         _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
     const_iterator upper_bound(_Tv &&__value) const noexcept {
-        return this->_M_upper_bound<_NodeImpl>(__value, _M_comp);
+        return this->_M_upper_bound<_NodeImpl>(__value, this->_M_key_comp());
     }
 
     template<class _Tv,
@@ -945,22 +1202,22 @@ public:
     }
 
     iterator lower_bound(_Tp const &__value) noexcept {
-        auto node = this->_M_lower_bound<_NodeImpl>(__value, _M_comp);
+        auto node = this->_M_lower_bound<_NodeImpl>(__value, this->_M_key_comp());
         return node == nullptr ? end() : node;
     }
 
     const_iterator lower_bound(_Tp const &__value) const noexcept {
-        auto node = this->_M_lower_bound<_NodeImpl>(__value, _M_comp);
+        auto node = this->_M_lower_bound<_NodeImpl>(__value, this->_M_key_comp());
         return node == nullptr ? end() : node;
     }
 
     iterator upper_bound(_Tp const &__value) noexcept {
-        auto node = this->_M_upper_bound<_NodeImpl>(__value, _M_comp);
+        auto node = this->_M_upper_bound<_NodeImpl>(__value, this->_M_key_comp());
         return node == nullptr ? end() : node;
     }
 
     const_iterator upper_bound(_Tp const &__value) const noexcept {
-        auto node = this->_M_upper_bound<_NodeImpl>(__value, _M_comp);
+        auto node = this->_M_upper_bound<_NodeImpl>(__value, this->_M_key_comp());
         return node == nullptr ? end() : node;
     }
 
@@ -982,7 +1239,7 @@ protected:
 
     template<class _Tv>
     bool _M_contains(_Tv &&__value) const noexcept {
-        return this->template _M_find_node<_NodeImpl>(__value, _M_comp) !=
+        return this->template _M_find_node<_NodeImpl>(__value, this->_M_key_comp()) !=
                nullptr;
     }
 
@@ -1043,6 +1300,37 @@ public:
         return reverse_iterator(min_temp,reverse_iterator::RENDOFF);
     }
 
+    // 按 key 的顺序对每个元素调用 __f，比迭代器循环少了父指针回溯和状态判断
+    // __f 中不能修改这棵树
+    template<class _Fn>
+    void for_each_inorder(_Fn __f) {
+        _RbTreeBase::_M_subtree_for_each<_NodeImpl>(this->_M_block->_M_root, __f);
+    }
+
+    template<class _Fn>
+    void for_each_inorder(_Fn __f) const {
+        auto __visit = [&__f](_Tp const &__value) {
+            __f(__value);
+        };
+        _RbTreeBase::_M_subtree_for_each<_NodeImpl>(this->_M_block->_M_root, __visit);
+    }
+
+    // 供 ParallelTree.hpp 使用：把树切成按中序排列、互不相交的任务
+    std::vector<_RbTreeChunk> _M_split(unsigned __depth) const {
+        std::vector<_RbTreeChunk> __chunks;
+        _RbTreeBase::_M_split_chunks(this->_M_block->_M_root, __depth, __chunks);
+        return __chunks;
+    }
+
+    template<class _Fn>
+    static void _M_chunk_for_each(_RbTreeChunk __chunk, _Fn &__f) {
+        if (__chunk._M_subtree) {
+            _RbTreeBase::_M_subtree_for_each<_NodeImpl>(__chunk._M_node, __f);
+        } else {
+            __f(static_cast<_NodeImpl *>(__chunk._M_node)->_M_value);
+        }
+    }
+
 // 提供用于调试目的的红黑树打印功能
 #ifndef NDEBUG
     template<class _Ostream>
@@ -11,10 +11,12 @@
 #include "RbTree.hpp"
 #include "Common.hpp"
 template <class _Tp, class _Compare = std::less<_Tp>,
-          class _Alloc = std::allocator<_Tp>>
-struct Set : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
-    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc>::const_iterator;
-    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc>::node_type;
+          class _Alloc = std::allocator<_Tp>,
+          class _NodeImpl = _RbTreeNodeImpl<_Tp const>,
+          class _Stats = _RbTreeNoStats>
+struct Set : _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats> {
+    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::const_iterator;
+    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::node_type;
     using iterator = const_iterator;
     using value_type = _Tp;
     using size_type = std::size_t;
@@ -23,12 +25,12 @@ struct Set : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
     Set() = default;
 
     explicit Set(_Compare __comp)
-        : _RbTreeImpl<_Tp const, _Compare, _Alloc>(__comp) {}
+        : _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>(__comp) {}
 
     Set(Set &&) = default;
     Set &operator=(Set &&) = default;
 
-    Set(Set const &__that) : _RbTreeImpl<_Tp const, _Compare, _Alloc>() {
+    Set(Set const &__that) : _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>() {
         this->_M_single_insert(__that.begin(), __that.end());
     }
 
@@ -81,7 +83,7 @@ struct Set : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
         return this->_M_single_insert(__first, __last);
     }
 
-    using _RbTreeImpl<_Tp const, _Compare, _Alloc>::assign;
+    using _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::assign;
 
     template <_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator,
                                                      _InputIt)>
@@ -90,7 +92,7 @@ struct Set : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
         return this->_M_single_insert(__first, __last);
     }
 
-    using _RbTreeImpl<_Tp const, _Compare, _Alloc>::erase;
+    using _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::erase;
 
     template <class _Tv, _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
     std::size_t erase(_Tv &&__value) {
@@ -132,10 +134,12 @@ struct Set : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
 };
 
 template <class _Tp, class _Compare = std::less<_Tp>,
-          class _Alloc = std::allocator<_Tp>>
-struct MultiSet : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
-    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc>::const_iterator;
-    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc>::node_type;
+          class _Alloc = std::allocator<_Tp>,
+          class _NodeImpl = _RbTreeNodeImpl<_Tp const>,
+          class _Stats = _RbTreeNoStats>
+struct MultiSet : _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats> {
+    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::const_iterator;
+    using typename _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::node_type;
     using iterator = const_iterator;
     using value_type = _Tp;
     using size_type = std::size_t;
@@ -144,13 +148,13 @@ struct MultiSet : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
     MultiSet() = default;
 
     explicit MultiSet(_Compare __comp)
-        : _RbTreeImpl<_Tp const, _Compare, _Alloc>(__comp) {}
+        : _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>(__comp) {}
 
     MultiSet(MultiSet &&) = default;
     MultiSet &operator=(MultiSet &&) = default;
 
     MultiSet(MultiSet const &__that)
-        : _RbTreeImpl<_Tp const, _Compare, _Alloc>() {
+        : _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>() {
         this->_M_multi_insert(__that.begin(), __that.end());
     }
 
@@ -203,7 +207,7 @@ struct MultiSet : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
         return this->_M_multi_insert(__first, __last);
     }
 
-    using _RbTreeImpl<_Tp const, _Compare, _Alloc>::assign;
+    using _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::assign;
 
     template <_LIBPENGCXX_REQUIRES_ITERATOR_CATEGORY(std::input_iterator,
                                                      _InputIt)>
@@ -212,7 +216,7 @@ struct MultiSet : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
         return this->_M_multi_insert(__first, __last);
     }
 
-    using _RbTreeImpl<_Tp const, _Compare, _Alloc>::erase;
+    using _RbTreeImpl<_Tp const, _Compare, _Alloc, _NodeImpl, _Stats>::erase;
 
     template <class _Tv, _LIBPENGCXX_REQUIRES_TRANSPARENT_COMPARE(_Compare, _Tv, _Tp)>
     std::size_t erase(_Tv &&__value) {
@@ -253,5 +257,22 @@ struct MultiSet : _RbTreeImpl<_Tp const, _Compare, _Alloc> {
     }
 };
 
+// 迭代器 ++/-- 只需一次指针读取的版本，适合大量区间扫描的场景
+template <class _Tp, class _Compare = std::less<_Tp>,
+          class _Alloc = std::allocator<_Tp>>
+using ThreadedSet = Set<_Tp, _Compare, _Alloc, _RbTreeThreadedNodeImpl<_Tp const>>;
+
+template <class _Tp, class _Compare = std::less<_Tp>,
+          class _Alloc = std::allocator<_Tp>>
+using ThreadedMultiSet = MultiSet<_Tp, _Compare, _Alloc, _RbTreeThreadedNodeImpl<_Tp const>>;
+
+// 统计比较、旋转、修复循环和节点分配次数的版本，通过 stats() / reset_stats() 读取和清零
+template <class _Tp, class _Compare = std::less<_Tp>,
+          class _Alloc = std::allocator<_Tp>>
+using InstrumentedSet = Set<_Tp, _Compare, _Alloc, _RbTreeNodeImpl<_Tp const>, _RbTreeStats>;
+
+template <class _Tp, class _Compare = std::less<_Tp>,
+          class _Alloc = std::allocator<_Tp>>
+using InstrumentedMultiSet = MultiSet<_Tp, _Compare, _Alloc, _RbTreeNodeImpl<_Tp const>, _RbTreeStats>;
 
 #endif //SET_HPP
@@ -1,6 +1,11 @@
+#ifndef SMARTPTR_HPP
+#define SMARTPTR_HPP
 #include <atomic>
+#include <cstdint>
 #include <cmath>
 #include <iostream>
+#include <iterator>
+#include <new>
 #include <utility>
 #include <vector>
 #include <concepts>
@@ -15,6 +20,11 @@ T exchange(T &dst,T val) {
 
 template <class T>
 struct DefaultDeleter {
+    DefaultDeleter() = default;
+    // 让 UniquePtr<Derived> 可以转成 UniquePtr<Base>
+    template<class U>
+        requires(std::convertible_to<U *,T *>)
+    DefaultDeleter(DefaultDeleter<U> const &) noexcept {}
     void operator()(T* p) const{
         delete p;
     }
@@ -44,6 +54,8 @@ template<class T,class Deleter = DefaultDeleter<T>>
 class UniquePtr {
 private:
     T *p_ = nullptr;
+    // 无状态的删除器不占空间，有状态的 (比如指向内存池的指针) 跟着指针一起移动
+    [[no_unique_address]] Deleter deleter_;
     template <class U,class UDeleter>
     friend class UniquePtr;
 public:
@@ -51,39 +63,48 @@ public:
     UniquePtr(std::nullptr_t dummy = nullptr) : p_(nullptr) {}
     // 自定义构造
     explicit UniquePtr(T *p) : p_(p) {}
+    UniquePtr(T *p,Deleter const &deleter) : p_(p),deleter_(deleter) {}
+    UniquePtr(T *p,Deleter &&deleter) : p_(p),deleter_(std::move(deleter)) {}
     ~UniquePtr() {
         if (p_ != nullptr) {
-            Deleter{}(p_);
+            deleter_(p_);
         }
         //puts("Destructor called");
     }
     UniquePtr(UniquePtr const &that) = delete;
     UniquePtr &operator=(UniquePtr const &that) = delete;
-    UniquePtr(UniquePtr &&that) noexcept {p_ = std::exchange(that.p_,nullptr);}
+    UniquePtr(UniquePtr &&that) noexcept:p_(std::exchange(that.p_,nullptr)),deleter_(std::move(that.deleter_)) {}
     UniquePtr &operator=(UniquePtr &&that) noexcept {
         if(this != &that) {
-            if(p_) {
-                Deleter{}(p_);
-                p_ = std::exchange(that.p_,nullptr);
-            }
+            reset(that.release());
+            deleter_ = std::move(that.deleter_);
         }
         return *this;
     }
     T *get()const {
         return p_;
     }
-    Deleter get_deleter()const {
-        return Deleter{};
+    Deleter &get_deleter() noexcept {
+        return deleter_;
+    }
+    Deleter const &get_deleter()const noexcept {
+        return deleter_;
+    }
+    explicit operator bool()const noexcept {
+        return p_ != nullptr;
     }
 
     T *release() {
         return std::exchange(p_,nullptr);
     }
     void reset(T *p = nullptr) {
-        if(p_) {
-            Deleter{}(p_);
+        if(T *old = std::exchange(p_,p)) {
+            deleter_(old);
         }
-        p_ = p;
+    }
+    void swap(UniquePtr &that) noexcept {
+        std::swap(p_,that.p_);
+        std::swap(deleter_,that.deleter_);
     }
     T *operator->()const {
         return p_;
@@ -93,19 +114,18 @@ public:
     }
     // 多态构造
     template<class U,class UDeleter>
-        requires(std::convertible_to<U *,T *>)
-    UniquePtr(UniquePtr<U,UDeleter> &&that) {
-        p_ = std::exchange(that.p_,nullptr);
-    }
+        requires(std::convertible_to<U *,T *> && std::convertible_to<UDeleter,Deleter>)
+    UniquePtr(UniquePtr<U,UDeleter> &&that):p_(std::exchange(that.p_,nullptr)),deleter_(std::move(that.deleter_)) {}
 };
 
 // 偏特化不能带默认值
 template<class T,class Deleter>
 class UniquePtr <T[],Deleter>:public UniquePtr<T,Deleter>{
+public:
     using UniquePtr<T, Deleter>::UniquePtr; // 继承构造函数
     std::add_lvalue_reference_t<T> operator[](std::size_t idx)const {
         return this->get()[idx];
-    };
+    }
 };
 
 
@@ -135,118 +155,343 @@ struct Cat final :public Animal {
 };
 
 //-------------------------------
+// 引用计数的线程安全策略，类似 Rust 的 Arc 与 Rc
+// 原子版本：可以在线程之间共享
+struct SpAtomicPolicy {
+    using counter_type = std::atomic<std::uint64_t>;
+    static constexpr bool thread_safe = true;   // 计数归零的块可以交给别的线程释放
+    static std::uint64_t load(counter_type const &cnt) noexcept {
+        return cnt.load(std::memory_order_acquire);
+    }
+    static std::uint64_t load_relaxed(counter_type const &cnt) noexcept {
+        return cnt.load(std::memory_order_relaxed);
+    }
+    static void add(counter_type &cnt,std::uint64_t val) noexcept {
+        cnt.fetch_add(val,std::memory_order_relaxed);
+    }
+    static std::uint64_t sub_release(counter_type &cnt,std::uint64_t val) noexcept {
+        return cnt.fetch_sub(val,std::memory_order_release);
+    }
+    static bool cas_acquire(counter_type &cnt,std::uint64_t &expected,std::uint64_t desired) noexcept {
+        return cnt.compare_exchange_weak(expected,desired,std::memory_order_acquire,std::memory_order_relaxed);
+    }
+    // 计数归零之后、销毁之前调用：对同一个计数做一次 acquire load，读到的值位于所有持有者 release 减计数
+    // 组成的 release sequence 之后，效果与 acquire 栅栏相同，而且 ThreadSanitizer 能够识别
+    static void acquire_after_release(counter_type const &cnt) noexcept {
+        (void)cnt.load(std::memory_order_acquire);
+    }
+};
+// 非原子版本：只能在一个线程内使用，复制和销毁都是普通的加减
+struct SpNonAtomicPolicy {
+    using counter_type = std::uint64_t;
+    static constexpr bool thread_safe = false;
+    static std::uint64_t load(counter_type const &cnt) noexcept {
+        return cnt;
+    }
+    static std::uint64_t load_relaxed(counter_type const &cnt) noexcept {
+        return cnt;
+    }
+    static void add(counter_type &cnt,std::uint64_t val) noexcept {
+        cnt += val;
+    }
+    static std::uint64_t sub_release(counter_type &cnt,std::uint64_t val) noexcept {
+        return std::exchange(cnt,cnt - val);
+    }
+    static bool cas_acquire(counter_type &cnt,std::uint64_t &expected,std::uint64_t desired) noexcept {
+        if(cnt != expected) {
+            expected = cnt;
+            return false;
+        }
+        cnt = desired;
+        return true;
+    }
+    static void acquire_after_release(counter_type const &) noexcept {}
+};
+
+// 延迟释放的挂钩 (见 DeferredRelease.hpp)
+// 当前线程处于 SpDeferredReleaseScope 中时，计数归零的控制块不立刻销毁对象，而是挂到线程本地的列表上，
+// 等到安全点或者交给后台线程再批量释放；不在 scope 中时只多一次 thread_local 读取，而且只发生在归零的路径上
+struct SpRetired {
+    void *cb;
+    void (*release)(void *) noexcept;
+};
+struct SpRetireList {
+    std::vector<SpRetired> items;
+    std::size_t batch = 0;
+    void *owner = nullptr;
+    void (*handoff)(SpRetireList &) noexcept = nullptr; // 不为空时攒够 batch 个就把列表交出去
+    static SpRetireList *&active() noexcept {
+        static thread_local SpRetireList *list = nullptr;
+        return list;
+    }
+    void push(SpRetired retired) {
+        items.push_back(retired);
+        if(handoff && items.size() >= batch) {
+            handoff(*this);
+        }
+    }
+};
+// 返回 false 表示调用者应当立刻释放
+inline bool spDeferRelease(void *cb,void (*release)(void *) noexcept) noexcept {
+    SpRetireList *list = SpRetireList::active();
+    if(!list) {
+        return false;
+    }
+    try {
+        list->push({cb,release});
+    }catch(...) {
+        return false;   // 列表扩容失败就退回到立即释放
+    }
+    return true;
+}
+
 // 控制块
+// 强引用归零时销毁对象 (dispose)，弱引用归零时释放控制块 (destroy)
+// 所有 SharedPtr 合起来只占弱引用的 1，这样最后一个 SharedPtr 和最后一个 WeakPtr 谁先走都可以
+// 两个计数放在同一个 64 位字里 (低 32 位强引用，高 32 位弱引用)，一次 load 就能判断调用者是否唯一的持有者
+template<class Policy = SpAtomicPolicy>
 struct SpControlBlock {
-    std::atomic_long refcnt_;
-    explicit SpControlBlock() :refcnt_(1) {}
+    static constexpr std::uint64_t kStrong = 1;
+    static constexpr std::uint64_t kWeak = std::uint64_t(1) << 32;
+    static constexpr std::uint64_t kStrongMask = kWeak - 1;
+    typename Policy::counter_type counts_;
+    explicit SpControlBlock() :counts_(kStrong + kWeak) {}
     SpControlBlock(SpControlBlock &&that) = delete;
     virtual ~SpControlBlock() = default;
-    void incref() {
-        refcnt_.fetch_add(1,std::memory_order_relaxed);
+    // 销毁被管理的对象
+    virtual void dispose() noexcept = 0;
+    // 释放控制块本身
+    virtual void destroy() noexcept {
+        delete this;
+    }
+    // 增加引用的一方已经持有一个引用，控制块不会在此期间消失，relaxed 即可
+    void incref() noexcept {
+        Policy::add(counts_,kStrong);
+    }
+    // WeakPtr::lock 用：对象已经销毁 (强引用为 0) 时不能再把它"复活"
+    bool incref_if_nonzero() noexcept {
+        std::uint64_t cnt = Policy::load_relaxed(counts_);
+        do {
+            if((cnt & kStrongMask) == 0) {
+                return false;
+            }
+        }while(!Policy::cas_acquire(counts_,cnt,cnt + kStrong));
+        return true;
+    }
+    // 每个持有者对对象的最后一次访问都要先于 dispose：减计数用 release，归零的一方再做一次 acquire
+    void deref() noexcept {
+        // 快速路径: 唯一的强引用且没有 WeakPtr，别的线程不可能再拿到这个控制块，省掉一次 RMW
+        if(Policy::load(counts_) == kStrong + kWeak) {
+            if(deferRelease()) {
+                return;     // 计数保持原样，releaseDeferred 里的 weakderef 会看到最后一个弱引用
+            }
+            dispose();
+            destroy();
+            return;
+        }
+        if((Policy::sub_release(counts_,kStrong) & kStrongMask) == 1) {
+            Policy::acquire_after_release(counts_);
+            if(deferRelease()) {
+                return;
+            }
+            dispose();
+            weakderef();
+        }
     }
-    void deref() {
-        if(refcnt_.fetch_sub(1,std::memory_order_relaxed) == 1) {
-            delete this;
+    // 只有线程安全的计数才允许延迟，非原子计数的块不能被后台线程释放
+    bool deferRelease() noexcept {
+        if constexpr (Policy::thread_safe) {
+            return spDeferRelease(this,&SpControlBlock::releaseDeferred);
+        }else {
+            return false;
+        }
+    }
+    static void releaseDeferred(void *p) noexcept {
+        auto *cb = static_cast<SpControlBlock *>(p);
+        cb->dispose();
+        cb->weakderef();
+    }
+    void weakincref() noexcept {
+        Policy::add(counts_,kWeak);
+    }
+    void weakderef() noexcept {
+        if((Policy::sub_release(counts_,kWeak) >> 32) == 1) {
+            Policy::acquire_after_release(counts_);
+            destroy();
         }
     }
     long cntref() const noexcept {
-        return refcnt_.load(std::memory_order_relaxed);
+        return static_cast<long>(Policy::load_relaxed(counts_) & kStrongMask);
     }
 };
-template<class T,class Deleter=DefaultDeleter<T>>
-struct SpControlBlockImpl final: public SpControlBlock{
+template<class T,class Deleter=DefaultDeleter<T>,class Policy=SpAtomicPolicy>
+struct SpControlBlockImpl final: public SpControlBlock<Policy>{
     T *data_;
     Deleter deleter_;
     explicit SpControlBlockImpl(T *ptr)noexcept:data_(ptr){}
     explicit SpControlBlockImpl(T *ptr,Deleter deleter)noexcept:data_(ptr),deleter_(std::move(deleter)){}
-    ~SpControlBlockImpl() noexcept override{
+    void dispose() noexcept override{
         deleter_(this->data_);
     }
 };
-template<class T,class Deleter=DefaultDeleter<T>>
-struct SpControlBlockImplFuse final:public SpControlBlock {
+template<class T,class Deleter=DefaultDeleter<T>,class Policy=SpAtomicPolicy>
+struct SpControlBlockImplFuse final:public SpControlBlock<Policy> {
     T *data_;
     void *mem_;     // 还有指向自己内存的指针
     [[no_unique_address]]Deleter deleter_;
 
     explicit SpControlBlockImplFuse(T *ptr,void *mem,Deleter deleter)noexcept:
         data_(ptr),mem_(mem),deleter_(std::move(deleter)) {}
-    ~SpControlBlockImplFuse() noexcept override {
+    // 强引用归零：只析构对象，内存要等弱引用也归零
+    void dispose() noexcept override {
         deleter_(this->data_);
+    }
+    // 弱引用归零：控制块和对象在同一块内存里，先析构自己再释放整块
+    void destroy() noexcept override {
+        void *mem = mem_;
+        this->~SpControlBlockImplFuse();
 #if __cpp_aligned_new
         // 释放整个分配块 : 这个地方同样是使用 std::align_val_t T 和 控制块 的最大值，因为我们就是这样分配的
-        ::operator delete(mem_,std::align_val_t(std::max(alignof(T),alignof(SpControlBlockImplFuse))));
+        ::operator delete(mem,std::align_val_t(std::max(alignof(T),alignof(SpControlBlockImplFuse))));
 #else
-        ::operator delete(mem_);
+        ::operator delete(mem);
 #endif
     }
-    // 相当于 = delete,我们必须要通过析构函数(该控制块作为成员的方式)来释放，而不是被 delete
+    // 相当于 = delete,我们必须通过 destroy 来释放，而不是被 delete
     void operator delete(void*)noexcept{}
 };
 
+// 数组版本的融合控制块：[控制块 | 对齐填充 | len_ 个元素]，整块内存只分配一次
+template<class T,class Policy=SpAtomicPolicy>
+struct SpControlBlockArrayFuse final:public SpControlBlock<Policy> {
+    std::size_t len_;   // 元素个数，析构时要用
+
+    // 元素开始的位置：控制块之后按 T 的对齐向上取整，和 makeShared 的 offset 算法一致
+    static constexpr std::size_t offset = alignof(T)>=sizeof(SpControlBlockArrayFuse)?alignof(T):((sizeof(SpControlBlockArrayFuse)+alignof(T)-1)/alignof(T))*alignof(T);
+    static constexpr std::size_t align = std::max(alignof(T),alignof(SpControlBlockArrayFuse));
+
+    explicit SpControlBlockArrayFuse(std::size_t len)noexcept:len_(len) {}
+    T *data()noexcept {
+        return reinterpret_cast<T *>(reinterpret_cast<char *>(this)+offset);
+    }
+    // 强引用归零：逆序析构所有元素
+    void dispose() noexcept override {
+        std::destroy(std::make_reverse_iterator(data()+len_),std::make_reverse_iterator(data()));
+    }
+    // 弱引用归零：控制块就在整块内存的开头
+    void destroy() noexcept override {
+        this->~SpControlBlockArrayFuse();
+        ::operator delete(static_cast<void *>(this),std::align_val_t(align));
+    }
+    void operator delete(void*)noexcept{}
+};
+
+// allocateShared 用的控制块：对象直接嵌在控制块里，整块内存由用户的分配器分配和释放
+template<class T,class Alloc,class Policy=SpAtomicPolicy>
+struct SpControlBlockImplAlloc final:public SpControlBlock<Policy> {
+    using ValueAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<std::remove_cv_t<T>>;
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<SpControlBlockImplAlloc>;
+    [[no_unique_address]] ValueAlloc alloc_;   // 记住分配器，destroy 时用它归还内存
+    alignas(T) unsigned char storage_[sizeof(T)];
+
+    explicit SpControlBlockImplAlloc(Alloc const &alloc)noexcept:alloc_(alloc) {}
+    std::remove_cv_t<T> *data()noexcept {
+        return reinterpret_cast<std::remove_cv_t<T> *>(storage_);
+    }
+    void dispose() noexcept override {
+        std::allocator_traits<ValueAlloc>::destroy(alloc_,data());
+    }
+    void destroy() noexcept override {
+        BlockAlloc alloc(alloc_);
+        this->~SpControlBlockImplAlloc();
+        std::allocator_traits<BlockAlloc>::deallocate(alloc,this,1);
+    }
+};
+
 // EnableFrom
-template<class T>
+template<class T,class Policy = SpAtomicPolicy>
 struct SharedPtr;
+template<class T,class Policy = SpAtomicPolicy>
+struct WeakPtr;
 
-template<class Derived>
+template<class Derived,class Policy = SpAtomicPolicy>
 struct EnableSharedFromThis {
 private:
-    SpControlBlock *cb_{nullptr};  // 分侵入式的加入 控制块 的 思想！
-    template<class T>
+    SpControlBlock<Policy> *cb_{nullptr};  // 分侵入式的加入 控制块 的 思想！
+    template<class,class>
     friend struct SharedPtr;
 public:
     EnableSharedFromThis() {}
-    SharedPtr<Derived> shared_from_this() noexcept{
+    // 对象正在析构 (强引用已经归零) 时同样抛出 bad_weak_ptr
+    SharedPtr<Derived,Policy> shared_from_this() {
         static_assert(std::is_base_of_v<EnableSharedFromThis,Derived>,"must be derived class");
-        if(!cb_) throw std::bad_weak_ptr();  // 根据标准如果不被 shared_ptr 管理则抛出一个该异常
-        cb_->incref();
+        if(!cb_ || !cb_->incref_if_nonzero()) throw std::bad_weak_ptr();  // 根据标准如果不被 shared_ptr 管理则抛出一个该异常
         return _makeSharedSpCounterOnce(static_cast<Derived*>(this),cb_);
     }
     // 为了防止 Derived 已经有了 const 所以我们要使用 std::add_const_t
-    SharedPtr<std::add_const_t<Derived>> shared_from_this() const noexcept{
+    SharedPtr<std::add_const_t<Derived>,Policy> shared_from_this() const {
         static_assert(std::is_base_of_v<EnableSharedFromThis,Derived>,"must be derived class");
-        if(!cb_) throw std::bad_weak_ptr();
-        cb_->incref();
+        if(!cb_ || !cb_->incref_if_nonzero()) throw std::bad_weak_ptr();
         return _makeSharedSpCounterOnce(static_cast<std::add_const_t<Derived>*>(this),cb_);
     }
-    template<class T>
-    friend inline void setEnableSharedFromThis(EnableSharedFromThis<T>*,SpControlBlock*);
+    // cb_ 只在对象存活时有效，而对象存活时控制块一定还在，所以这里不需要额外持有弱引用
+    WeakPtr<Derived,Policy> weak_from_this() noexcept {
+        return WeakPtr<Derived,Policy>(static_cast<Derived*>(this),cb_);
+    }
+    WeakPtr<std::add_const_t<Derived>,Policy> weak_from_this() const noexcept {
+        return WeakPtr<std::add_const_t<Derived>,Policy>(static_cast<std::add_const_t<Derived>*>(this),cb_);
+    }
+    template<class T,class P>
+    friend inline void setEnableSharedFromThis(EnableSharedFromThis<T,P>*,SpControlBlock<P>*);
 };
 
 // SharedPtr
-template<class T>
+template<class T,class Policy>
 struct SharedPtr {
 private:
     T *ptr_ = nullptr;
-    SpControlBlock *cb_ = nullptr;
+    SpControlBlock<Policy> *cb_ = nullptr;
     // 声明友元类
-    template<class>
-    friend class SharedPtr;
+    template<class,class>
+    friend struct SharedPtr;
+    template<class,class>
+    friend struct WeakPtr;
     // 支持分配到一块内存,内联函数直接定义在头文件中
-    template<class Y>
-    friend inline SharedPtr<Y> _makeSharedSpCounterOnce(Y *ptr,SpControlBlock *cb);
+    template<class Y,class P>
+    friend inline SharedPtr<Y,P> _makeSharedSpCounterOnce(Y *ptr,SpControlBlock<P> *cb);
 
-    explicit SharedPtr(T *ptr,SpControlBlock *cb)noexcept:ptr_(ptr),cb_(cb) {}
+    explicit SharedPtr(T *ptr,SpControlBlock<Policy> *cb)noexcept:ptr_(ptr),cb_(cb) {}
 
-    template<class Y>
-    friend inline void _setEnableSharedFromThisOwner(EnableSharedFromThis<Y>*,SpControlBlock*);
+    template<class Y,class P>
+    friend inline void _setEnableSharedFromThisOwner(EnableSharedFromThis<Y,P>*,SpControlBlock<P>*);
 public:
     using element_type = T;
     using pointer = T*;
     SharedPtr(std::nullptr_t = nullptr)noexcept:cb_(nullptr){}
 
-    template<class Y,std::enable_if_t<!std::is_base_of_v<EnableSharedFromThis<Y>,Y>,int> = 0,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
-    explicit SharedPtr(Y *ptr):ptr_(ptr) ,cb_(new SpControlBlockImpl<Y,DefaultDeleter<Y>>(ptr)){}
-    template<class Y,std::enable_if_t<std::is_base_of_v<EnableSharedFromThis<Y>,Y>,int> = 0,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
-    explicit SharedPtr(Y *ptr):ptr_(ptr) ,cb_(new SpControlBlockImpl<Y,DefaultDeleter<Y>>(ptr)) {
+    template<class Y,std::enable_if_t<!std::is_base_of_v<EnableSharedFromThis<Y,Policy>,Y>,int> = 0,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    explicit SharedPtr(Y *ptr):ptr_(ptr) ,cb_(new SpControlBlockImpl<Y,DefaultDeleter<Y>,Policy>(ptr)){}
+    template<class Y,std::enable_if_t<std::is_base_of_v<EnableSharedFromThis<Y,Policy>,Y>,int> = 0,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    explicit SharedPtr(Y *ptr):ptr_(ptr) ,cb_(new SpControlBlockImpl<Y,DefaultDeleter<Y>,Policy>(ptr)) {
         ptr_->cb_ = this->cb_;
     }
 
     template<class Y,class Deleter,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
-    explicit SharedPtr(Y *ptr,Deleter deleter):ptr_(ptr),cb_(new SpControlBlockImpl<Y,Deleter>(ptr,std::move(deleter))) {}
+    explicit SharedPtr(Y *ptr,Deleter deleter):ptr_(ptr),cb_(new SpControlBlockImpl<Y,Deleter,Policy>(ptr,std::move(deleter))) {}
+    // 从 WeakPtr 构造，对象已经销毁时抛出 bad_weak_ptr
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    explicit SharedPtr(WeakPtr<Y,Policy> const &that):ptr_(that.ptr_),cb_(that.cb_) {
+        if(!cb_ || !cb_->incref_if_nonzero()) throw std::bad_weak_ptr();
+    }
     // 支持从 UniquePtr 构造
+    // 控制块创建成功之后才让 UniquePtr 放手，分配失败时对象仍由它负责；空的 UniquePtr 得到空的 SharedPtr
     template<class Y,class Deleter,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
-    explicit SharedPtr(UniquePtr<Y,Deleter> &&ptr):SharedPtr(ptr.get(),ptr->get_deleter()) {}
+    explicit SharedPtr(UniquePtr<Y,Deleter> &&ptr) {
+        if(ptr.get() != nullptr) {
+            cb_ = new SpControlBlockImpl<Y,Deleter,Policy>(ptr.get(),ptr.get_deleter());
+            ptr_ = ptr.release();
+        }
+    }
 
     SharedPtr &operator=(SharedPtr const &that) noexcept{
         if(this == &that) {
@@ -270,7 +515,7 @@ public:
         return *this;
     }
     template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
-    SharedPtr &operator=(SharedPtr<Y> const&that)noexcept {
+    SharedPtr &operator=(SharedPtr<Y,Policy> const&that)noexcept {
         if(this == &that) { return *this;}
         if(cb_) cb_->deref();
         ptr_ = that.ptr_;
@@ -279,7 +524,7 @@ public:
         return *this;
     }
     template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
-    SharedPtr &operator=(SharedPtr<Y> &&that)noexcept {
+    SharedPtr &operator=(SharedPtr<Y,Policy> &&that)noexcept {
         if(this == &that) { return *this;}
         if(cb_) cb_->deref();
         ptr_ = that.ptr_;
@@ -290,28 +535,28 @@ public:
     }
     // 添加隐式转换函数
     template<class Y,std::enable_if_t<std::convertible_to<Y*,T*>,int> = 0>
-    SharedPtr(SharedPtr<Y> const &that) noexcept:ptr_(that.ptr_),cb_(that.cb_) {
+    SharedPtr(SharedPtr<Y,Policy> const &that) noexcept:ptr_(that.ptr_),cb_(that.cb_) {
         if(cb_) cb_->incref();
     }
     template<class Y,std::enable_if_t<std::convertible_to<Y*,T*>,int> = 0>
-    SharedPtr(SharedPtr<Y> &&that) noexcept:ptr_(that.ptr_),cb_(that.cb_) {
+    SharedPtr(SharedPtr<Y,Policy> &&that) noexcept:ptr_(that.ptr_),cb_(that.cb_) {
         that.ptr_ = nullptr;
         that.cb_ = nullptr;
     }
     template<class Y>
-    bool operator<(SharedPtr<Y> const &that) const noexcept {
+    bool operator<(SharedPtr<Y,Policy> const &that) const noexcept {
         return ptr_ < that.ptr_;
     }
     template<class Y>
-    bool operator==(SharedPtr<T> const &that)const noexcept {
+    bool operator==(SharedPtr<T,Policy> const &that)const noexcept {
         return ptr_ == that.ptr_;
     }
     template<class Y>
-    bool owner_before(SharedPtr<Y> const &that) noexcept {
+    bool owner_before(SharedPtr<Y,Policy> const &that) noexcept {
         return cb_ < that.cb_;
     }
     template<class Y>
-    bool owner_equal(SharedPtr<Y> const &that)const noexcept {
+    bool owner_equal(SharedPtr<Y,Policy> const &that)const noexcept {
         return cb_ == that.cb_;
     }
     void swap(SharedPtr &that) {
@@ -329,7 +574,7 @@ public:
         cb_ = nullptr;
         ptr_ = nullptr;
         ptr_ = ptr;
-        cb_ = new SpControlBlockImpl<Y,DefaultDeleter<Y>>(ptr);
+        cb_ = new SpControlBlockImpl<Y,DefaultDeleter<Y>,Policy>(ptr);
     }
     template<class Y,class Deleter>
     void reset(Y *ptr,Deleter deleter) {
@@ -338,7 +583,7 @@ public:
         cb_ = nullptr;
         ptr_ = nullptr;
         ptr_ = ptr;
-        cb_ = new SpControlBlockImpl<Y,Deleter>(ptr,std::move(deleter));
+        cb_ = new SpControlBlockImpl<Y,Deleter,Policy>(ptr,std::move(deleter));
     }
     ~SharedPtr() {
         if(cb_)
@@ -365,53 +610,74 @@ public:
         return cb_?cb_->cntref():0;
     }
     bool unique()noexcept {
-        return cb_?cb_->refcnt_==1:false;
+        return cb_?cb_->cntref()==1:false;
     }
     // 支持 staticPointerCast 函数,加上 std::enable_if_t<std::convertible_to<Y*,T*>,int> = 0 负责隐式转换
     template<class Y>
-    SharedPtr(SharedPtr<Y> const &that,T *ptr) noexcept:ptr_(ptr),cb_(that.cb_) {
+    SharedPtr(SharedPtr<Y,Policy> const &that,T *ptr) noexcept:ptr_(ptr),cb_(that.cb_) {
         if(cb_)cb_->incref();
     }
     //加上 std::enable_if_t<std::convertible_to<Y*,T*>,int> = 0 负责隐式转换
     template<class Y>
-    SharedPtr(SharedPtr<Y> &&that,T *ptr) noexcept:ptr_(ptr),cb_(that.cb_) {
+    SharedPtr(SharedPtr<Y,Policy> &&that,T *ptr) noexcept:ptr_(ptr),cb_(that.cb_) {
         that.ptr_=nullptr;
         that.cb_=nullptr;
     }
 
 };
 //支持数组
-template<class T>
-class SharedPtr<T[]>:public SharedPtr<T>{
-    using SharedPtr<T>::UniquePtr; // 继承构造函数
+template<class T,class Policy>
+struct SharedPtr<T[],Policy>:public SharedPtr<T,Policy>{
+private:
+    template<class Y,class P>
+    friend inline SharedPtr<Y[],P> _makeSharedArraySpCounterOnce(Y *ptr,SpControlBlock<P> *cb);
+
+    explicit SharedPtr(T *ptr,SpControlBlock<Policy> *cb)noexcept:SharedPtr<T,Policy>(ptr,cb) {}
+public:
+    using element_type = T;
+    using SharedPtr<T,Policy>::SharedPtr; // 继承构造函数
+    SharedPtr(std::nullptr_t = nullptr)noexcept {}
+    // 裸指针来自 new T[]，要用 delete[] 释放
+    explicit SharedPtr(T *ptr):SharedPtr<T,Policy>(ptr,DefaultDeleter<T[]>{}) {}
+    // 例如 SharedPtr<int[]> 到 SharedPtr<int const[]>
+    template<class Y,std::enable_if_t<std::convertible_to<Y*,T*>,int> = 0>
+    SharedPtr(SharedPtr<Y[],Policy> const &that)noexcept:SharedPtr<T,Policy>(static_cast<SharedPtr<Y,Policy> const &>(that)) {}
+    template<class Y,std::enable_if_t<std::convertible_to<Y*,T*>,int> = 0>
+    SharedPtr(SharedPtr<Y[],Policy> &&that)noexcept:SharedPtr<T,Policy>(static_cast<SharedPtr<Y,Policy> &&>(that)) {}
+
     std::add_lvalue_reference_t<T> operator[](std::size_t idx)const {
         return this->get()[idx];
-    };
+    }
 };
 // 支持实现 make_shared
-template<class T>
-SharedPtr<T> _makeSharedSpCounterOnce(T *ptr,SpControlBlock *cb) {
-    return SharedPtr<T>(ptr,cb);
+template<class T,class Policy>
+SharedPtr<T,Policy> _makeSharedSpCounterOnce(T *ptr,SpControlBlock<Policy> *cb) {
+    return SharedPtr<T,Policy>(ptr,cb);
+}
+template<class T,class Policy>
+SharedPtr<T[],Policy> _makeSharedArraySpCounterOnce(T *ptr,SpControlBlock<Policy> *cb) {
+    return SharedPtr<T[],Policy>(ptr,cb);
 }
 // 支持 enable_shared_from_this: SFIAE
-template<class T>
-inline void setEnableSharedFromThis(EnableSharedFromThis<T>*ptr,SpControlBlock*cb) {
+template<class T,class Policy>
+inline void setEnableSharedFromThis(EnableSharedFromThis<T,Policy>*ptr,SpControlBlock<Policy>*cb) {
     ptr->cb_ = cb;
 }
-template<class T,std::enable_if_t<std::is_base_of_v<EnableSharedFromThis<T>,T>,int> = 0>
-inline void setupEnableSharedFromThis(T* ptr,SpControlBlock* cb) {
-    setEnableSharedFromThis(static_cast<EnableSharedFromThis<T>*>(ptr),cb);
+template<class T,class Policy,std::enable_if_t<std::is_base_of_v<EnableSharedFromThis<T,Policy>,T>,int> = 0>
+inline void setupEnableSharedFromThis(T* ptr,SpControlBlock<Policy>* cb) {
+    setEnableSharedFromThis(static_cast<EnableSharedFromThis<T,Policy>*>(ptr),cb);
 }
-template<class T,std::enable_if_t<!std::is_base_of_v<EnableSharedFromThis<T>,T>,int> = 0>
-void setupEnableSharedFromThis(T *ptr,SpControlBlock *cb) {}
+template<class T,class Policy,std::enable_if_t<!std::is_base_of_v<EnableSharedFromThis<T,Policy>,T>,int> = 0>
+void setupEnableSharedFromThis(T *ptr,SpControlBlock<Policy> *cb) {}
 
 
-template<class T,class...Args,std::enable_if_t<!std::is_unbounded_array_v<T>,int> = 0>
-SharedPtr<T> makeShared(Args&&...args) {
+// Policy 选择计数方式，例如 makeShared<Foo,SpNonAtomicPolicy>(...) 得到只在单线程内使用的 SharedPtr
+template<class T,class Policy = SpAtomicPolicy,class...Args,std::enable_if_t<!std::is_unbounded_array_v<T>,int> = 0>
+SharedPtr<T,Policy> makeShared(Args&&...args) {
     auto const deleter = [](T *ptr) noexcept {
         ptr->~T();
     };
-    using Counter = SpControlBlockImplFuse<T,decltype(deleter)>; //控制块的类型
+    using Counter = SpControlBlockImplFuse<T,decltype(deleter),Policy>; //控制块的类型
     // T 的开始位置： 控制块放在前面，所以开始位置
     constexpr std::size_t offset = alignof(T)>=sizeof(Counter)?alignof(T):((sizeof(Counter)+alignof(T)-1)/alignof(T))*alignof(T);
     //constexpr std::size_t offset = std::max(alignof(T),sizeof(Counter));
@@ -435,54 +701,173 @@ SharedPtr<T> makeShared(Args&&...args) {
 #endif
         throw;
     }
-    static_assert(std::is_same_v<Counter,SpControlBlockImplFuse<T,decltype(deleter)>>);
+    static_assert(std::is_same_v<Counter,SpControlBlockImplFuse<T,decltype(deleter),Policy>>);
     new (ptr) Counter(obj,mem,deleter);
 
-    setupEnableSharedFromThis(obj,ptr);
-    return _makeSharedSpCounterOnce(obj,ptr);
+    setupEnableSharedFromThis(obj,static_cast<SpControlBlock<Policy>*>(ptr));
+    return _makeSharedSpCounterOnce(obj,static_cast<SpControlBlock<Policy>*>(ptr));
 }
 
-template<class T,std::enable_if_t<!std::is_unbounded_array_v<T>,int> = 0>
-SharedPtr<T> makeSharedForOverwrite() {
-    return SharedPtr<T>(new T);
+// 与 makeShared 相同只分配一次，但内存来自 alloc (会被 rebind 成控制块类型)，适合配合池分配器使用
+template<class T,class Policy = SpAtomicPolicy,class Alloc,class...Args,std::enable_if_t<!std::is_unbounded_array_v<T>,int> = 0>
+SharedPtr<T,Policy> allocateShared(Alloc const &alloc,Args&&...args) {
+    using Counter = SpControlBlockImplAlloc<T,Alloc,Policy>;
+    typename Counter::BlockAlloc block_alloc(alloc);
+    Counter *cb = std::allocator_traits<typename Counter::BlockAlloc>::allocate(block_alloc,1);
+    new (cb) Counter(alloc);
+    try {
+        std::allocator_traits<typename Counter::ValueAlloc>::construct(cb->alloc_,cb->data(),std::forward<Args>(args)...);
+    }catch(...) {
+        cb->~Counter();
+        std::allocator_traits<typename Counter::BlockAlloc>::deallocate(block_alloc,cb,1);
+        throw;
+    }
+    T *obj = cb->data();
+    setupEnableSharedFromThis(obj,static_cast<SpControlBlock<Policy>*>(cb));
+    return _makeSharedSpCounterOnce(obj,static_cast<SpControlBlock<Policy>*>(cb));
 }
-template<class T,class...Args,std::enable_if_t<std::is_unbounded_array_v<T>,int> = 0>
-SharedPtr<T> makeShared(std::size_t len) {
-    return SharedPtr<T>(new std::remove_extent_t<T>[len]());
+
+template<class T,class Policy = SpAtomicPolicy,std::enable_if_t<!std::is_unbounded_array_v<T>,int> = 0>
+SharedPtr<T,Policy> makeSharedForOverwrite() {
+    return SharedPtr<T,Policy>(new T);
+}
+// 数组版本：控制块、长度和元素放在同一块内存里；Overwrite 为 true 时元素只做默认初始化
+template<class T,class Policy,bool Overwrite>
+SharedPtr<T[],Policy> _makeSharedArray(std::size_t len) {
+    using Counter = SpControlBlockArrayFuse<T,Policy>;
+    if(len > (std::size_t(-1)-Counter::offset)/sizeof(T)) {
+        throw std::bad_array_new_length();
+    }
+    std::size_t const size = Counter::offset + sizeof(T)*len;
+    void *mem = ::operator new(size,std::align_val_t(Counter::align));
+    Counter *ptr = new (mem) Counter(len);
+    T *first = ptr->data();
+    std::size_t i = 0;
+    try {
+        for(;i < len;++i) {
+            if constexpr (Overwrite) {
+                new (first+i) T;
+            }else {
+                new (first+i) T();
+            }
+        }
+    }catch(...) {
+        std::destroy(std::make_reverse_iterator(first+i),std::make_reverse_iterator(first));
+        ::operator delete(mem,std::align_val_t(Counter::align));
+        throw;
+    }
+    return _makeSharedArraySpCounterOnce(first,static_cast<SpControlBlock<Policy>*>(ptr));
 }
-template<class T,std::enable_if_t<std::is_unbounded_array_v<T>,int> = 0>
-SharedPtr<T> makeSharedForOverwrite(std::size_t len) {
-    return SharedPtr<T>(new std::remove_extent_t<T>[len]);
+template<class T,class Policy = SpAtomicPolicy,std::enable_if_t<std::is_unbounded_array_v<T>,int> = 0>
+SharedPtr<T,Policy> makeShared(std::size_t len) {
+    return _makeSharedArray<std::remove_extent_t<T>,Policy,false>(len);
+}
+template<class T,class Policy = SpAtomicPolicy,std::enable_if_t<std::is_unbounded_array_v<T>,int> = 0>
+SharedPtr<T,Policy> makeSharedForOverwrite(std::size_t len) {
+    return _makeSharedArray<std::remove_extent_t<T>,Policy,true>(len);
 }
 
 
-template<class T>
-struct WeakPtr{};
+// 不延长对象的寿命，只延长控制块的寿命；用 lock() 换取一个 SharedPtr
+template<class T,class Policy>
+struct WeakPtr {
+private:
+    T *ptr_ = nullptr;
+    SpControlBlock<Policy> *cb_ = nullptr;
+    template<class,class>
+    friend struct WeakPtr;
+    template<class,class>
+    friend struct SharedPtr;
+    template<class,class>
+    friend struct EnableSharedFromThis;
+
+    explicit WeakPtr(T *ptr,SpControlBlock<Policy> *cb)noexcept:ptr_(ptr),cb_(cb) {
+        if(cb_) cb_->weakincref();
+    }
+public:
+    using element_type = T;
+    WeakPtr(std::nullptr_t = nullptr)noexcept {}
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    WeakPtr(SharedPtr<Y,Policy> const &that)noexcept:WeakPtr(that.ptr_,that.cb_) {}
+    WeakPtr(WeakPtr const &that)noexcept:WeakPtr(that.ptr_,that.cb_) {}
+    WeakPtr(WeakPtr &&that)noexcept:ptr_(that.ptr_),cb_(that.cb_) {
+        that.ptr_ = nullptr;
+        that.cb_ = nullptr;
+    }
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    WeakPtr(WeakPtr<Y,Policy> const &that)noexcept:WeakPtr(that.ptr_,that.cb_) {}
+    template<class Y,std::enable_if_t<std::is_convertible_v<Y*,T*>,int> = 0>
+    WeakPtr(WeakPtr<Y,Policy> &&that)noexcept:ptr_(that.ptr_),cb_(that.cb_) {
+        that.ptr_ = nullptr;
+        that.cb_ = nullptr;
+    }
+    // 统一用 copy-and-swap，自赋值也是安全的
+    WeakPtr &operator=(WeakPtr that)noexcept {
+        swap(that);
+        return *this;
+    }
+    ~WeakPtr() {
+        if(cb_) cb_->weakderef();
+    }
+    void swap(WeakPtr &that)noexcept {
+        std::swap(ptr_,that.ptr_);
+        std::swap(cb_,that.cb_);
+    }
+    void reset()noexcept {
+        WeakPtr().swap(*this);
+    }
+    long use_count()const noexcept {
+        return cb_?cb_->cntref():0;
+    }
+    bool expired()const noexcept {
+        return use_count() == 0;
+    }
+    // 对象还活着就返回共享它的 SharedPtr，否则返回空
+    SharedPtr<T,Policy> lock()const noexcept {
+        if(cb_ && cb_->incref_if_nonzero()) {
+            return _makeSharedSpCounterOnce(ptr_,cb_);
+        }
+        return nullptr;
+    }
+    template<class Y>
+    bool owner_before(WeakPtr<Y,Policy> const &that)const noexcept {
+        return cb_ < that.cb_;
+    }
+    template<class Y>
+    bool owner_before(SharedPtr<Y,Policy> const &that)const noexcept {
+        return cb_ < that.cb_;
+    }
+};
+
 
 
+// 只在单线程内使用的版本，引用计数是普通整数
+template<class T>
+using LocalSharedPtr = SharedPtr<T,SpNonAtomicPolicy>;
+template<class T>
+using LocalWeakPtr = WeakPtr<T,SpNonAtomicPolicy>;
 
-template<class T,class U>
-SharedPtr<T> staticPointerCast(SharedPtr<U> const &ptr) {
-    return SharedPtr<T>(ptr,static_cast<T *>(ptr.get())); //拿到控制块
+template<class T,class U,class Policy>
+SharedPtr<T,Policy> staticPointerCast(SharedPtr<U,Policy> const &ptr) {
+    return SharedPtr<T,Policy>(ptr,static_cast<T *>(ptr.get())); //拿到控制块
 }
 
-template<class T,class U>
-SharedPtr<T> constPointerCast(SharedPtr<U> const &ptr) {
-    return SharedPtr<T>(ptr,const_cast<T *>(ptr.get()));
+template<class T,class U,class Policy>
+SharedPtr<T,Policy> constPointerCast(SharedPtr<U,Policy> const &ptr) {
+    return SharedPtr<T,Policy>(ptr,const_cast<T *>(ptr.get()));
 }
 
-template<class T,class U>
-SharedPtr<T> reinterpretPointerCast(SharedPtr<U> const &ptr) {
-    return SharedPtr<T>(ptr,reinterpret_cast<T *>(ptr.get()));
+template<class T,class U,class Policy>
+SharedPtr<T,Policy> reinterpretPointerCast(SharedPtr<U,Policy> const &ptr) {
+    return SharedPtr<T,Policy>(ptr,reinterpret_cast<T *>(ptr.get()));
 }
 
-template<class T,class U>
-SharedPtr<T> dynamicPointerCast(SharedPtr<U> const &ptr) {
+template<class T,class U,class Policy>
+SharedPtr<T,Policy> dynamicPointerCast(SharedPtr<U,Policy> const &ptr) {
     if(auto *p = dynamic_cast<T*>(ptr.get())) {
-        return SharedPtr<T>(ptr,p);
+        return SharedPtr<T,Policy>(ptr,p);
     }
     return nullptr;
 }
 
-
-
+#endif //SMARTPTR_HPP
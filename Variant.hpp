@@ -4,8 +4,13 @@
 ///
 #ifndef VARIANT_HPP
 #define VARIANT_HPP
+#include <cstddef>
+#include <exception>
 #include <functional>
+#include <memory>
 #include <type_traits>
+#include <utility>
+#include "Common.hpp"
 
 template <size_t I>
 struct InPlaceIndex {
@@ -29,112 +34,238 @@ struct BadVariantAccess : std::exception {
 template<typename, typename> // typename -> size_t
 struct VariantIndex;
 
-template<typename, size_t> // size_t -> typename
-struct VariantAlternative;
+// 把运行时的下标变成编译期常量: f(std::integral_constant<size_t, I>{})
+// 候选项不多时展开成 switch，编译器可以内联每一个分支；太多时退回到常量函数指针表 (常量初始化，没有 static 的守卫检查)
+constexpr size_t variant_switch_max = 16;
 
+template<typename R, typename F, size_t I>
+constexpr R variant_invoke_at(F &&f) {
+    return std::forward<F>(f)(std::integral_constant<size_t, I>{});
+}
 
-template<typename... Ts>
-struct Variant {
-private:
-    size_t index_;
-    alignas(std::max({alignof(Ts)...})) char union_[std::max({sizeof(Ts)...})];
+template<typename R, typename F, size_t... Is>
+inline constexpr R (*variant_dispatch_table[])(F &&) = {&variant_invoke_at<R, F, Is>...};
 
-    using DestructorFunction = void(*)(char *) noexcept;
+template<typename R, typename F, size_t... Is>
+constexpr R variant_table_dispatch(size_t i, F &&f, std::index_sequence<Is...>) {
+    return variant_dispatch_table<R, F, Is...>[i](std::forward<F>(f));
+}
 
-    static DestructorFunction *destructors_table() noexcept {
-        static DestructorFunction function_ptrs[sizeof...(Ts)] = {
-            [] (char *union_) noexcept {
-                reinterpret_cast<Ts *>(union_)->~Ts();
-            }...
-        };
-        return function_ptrs;
+#define VARIANT_DISPATCH_CASE(I) \
+    case I: \
+        if constexpr (I < N) { \
+            return std::forward<F>(f)(std::integral_constant<size_t, I>{}); \
+        } \
+        break;
+
+template<typename R, size_t N, typename F>
+constexpr R variant_dispatch(size_t i, F &&f) {
+    if constexpr (N > variant_switch_max) {
+        return variant_table_dispatch<R>(i, std::forward<F>(f), std::make_index_sequence<N>{});
+    } else {
+        switch (i) {
+            VARIANT_DISPATCH_CASE(0) VARIANT_DISPATCH_CASE(1) VARIANT_DISPATCH_CASE(2) VARIANT_DISPATCH_CASE(3)
+            VARIANT_DISPATCH_CASE(4) VARIANT_DISPATCH_CASE(5) VARIANT_DISPATCH_CASE(6) VARIANT_DISPATCH_CASE(7)
+            VARIANT_DISPATCH_CASE(8) VARIANT_DISPATCH_CASE(9) VARIANT_DISPATCH_CASE(10) VARIANT_DISPATCH_CASE(11)
+            VARIANT_DISPATCH_CASE(12) VARIANT_DISPATCH_CASE(13) VARIANT_DISPATCH_CASE(14) VARIANT_DISPATCH_CASE(15)
+            default:
+                break;
+        }
+        _LIBPENGCXX_UNREACHABLE(); // index_ 总是小于 N
     }
+}
+#undef VARIANT_DISPATCH_CASE
 
-    using MoveConstructorFunction = void(*)(char *, char *) noexcept;
+template<typename, size_t> // size_t -> typename
+struct VariantAlternative;
 
-    static MoveConstructorFunction *move_constructors_table() noexcept {
-        static MoveConstructorFunction function_ptrs[sizeof...(Ts)] = {
-            [] (char *union_dst, char *union_src) noexcept {
-                new (union_dst) Ts(std::move(*reinterpret_cast<Ts *>(union_src)));
-            }...
-        };
-        return function_ptrs;
-    }
+template<size_t N>
+using variant_index_t = std::conditional_t<(N <= 0xff), unsigned char,
+                        std::conditional_t<(N <= 0xffff), unsigned short, unsigned int> >;
 
-    using CopyAssignmentFunction = void(*)(char *, char const *) noexcept;
+template<typename>
+struct VariantSize;
 
-    static CopyAssignmentFunction *copy_assigment_functions_table() noexcept {
-        static CopyAssignmentFunction function_ptrs[sizeof...(Ts)] = {
-            [] (char *union_dst, char const *union_src) noexcept {
-                *reinterpret_cast<Ts *>(union_dst) = *reinterpret_cast<Ts const*>(union_src);
-            }...
-        };
-        return function_ptrs;
-    }
+// 递归的 union 存储: head_ 是第 0 个候选项，tail_ 装剩下的；
+// 不需要 reinterpret_cast 和 placement new，字面类型的 Variant 可以在编译期构造和访问
+template<typename... Ts>
+union VariantUnion;
+
+template<>
+union VariantUnion<> {};
 
-    using MoveAssignmentFunction = void(*)(char *, char *) noexcept;
+template<typename T, typename... Ts>
+union VariantUnion<T, Ts...> {
+    char dummy_;    // 还没有构造任何候选项时的活跃成员
+    T head_;
+    VariantUnion<Ts...> tail_;
+
+    constexpr VariantUnion() noexcept : dummy_() {}
+
+    template<typename... Args>
+    constexpr explicit VariantUnion(InPlaceIndex<0>, Args &&...args) : head_(std::forward<Args>(args)...) {}
+
+    template<size_t I, typename... Args>
+    constexpr explicit VariantUnion(InPlaceIndex<I>, Args &&...args)
+        : tail_(inPlaceIndex<I - 1>, std::forward<Args>(args)...) {}
+
+    // 候选项都平凡时保持平凡，否则由 Variant 负责复制和析构活跃的成员
+    VariantUnion(VariantUnion const &) = default;
+    VariantUnion(VariantUnion &&) = default;
+    VariantUnion &operator=(VariantUnion const &) = default;
+    VariantUnion &operator=(VariantUnion &&) = default;
+    ~VariantUnion() requires (std::is_trivially_destructible_v<T> && ... && std::is_trivially_destructible_v<Ts>) = default;
+    constexpr ~VariantUnion() {}
+};
 
-    static MoveAssignmentFunction *move_assigment_functions_table() noexcept {
-        static MoveAssignmentFunction function_ptrs[sizeof...(Ts)] = {
-            [] (char *union_dst, char *union_src) noexcept {
-                *reinterpret_cast<Ts *>(union_dst) = std::move(*reinterpret_cast<Ts *>(union_src));
-            }...
-        };
-        return function_ptrs;
+// 不检查下标地取出第 I 个候选项，保留 V 的 const 和值类别 (左值/右值)
+struct VariantAccess {
+    template<size_t I, typename U>
+    static constexpr decltype(auto) get_union(U &&u) noexcept {
+        if constexpr (I == 0) {
+            return (std::forward<U>(u).head_);
+        } else {
+            return get_union<I - 1>(std::forward<U>(u).tail_);
+        }
     }
 
+    template<size_t I, typename V>
+    static constexpr decltype(auto) get(V &&v) noexcept {
+        return get_union<I>(std::forward<V>(v).union_);
+    }
+};
 
-    template<class Lambda>
-    using VisitorFunction = std::common_type<typename std::invoke_result<Lambda, Ts &>::type...>::type(*)(
-        char *, Lambda &&);
 
-    template<class Lambda>
-    static VisitorFunction<Lambda> *visitors_table() noexcept {
-        static VisitorFunction<Lambda> function_ptrs[sizeof...(Ts)] = {
-            [](char *union_p,
-               Lambda &&lambda) -> std::common_type<typename std::invoke_result<Lambda, Ts &>::type...>::type {
-                return std::invoke(std::forward<Lambda>(lambda),
-                                   *reinterpret_cast<Ts *>(union_p));
-            }...
-        };
-        return function_ptrs;
+template<typename... Ts>
+struct Variant {
+private:
+    friend struct VariantAccess;
+
+    // 下标放在存储之后，并且用能装下 sizeof...(Ts) 的最小无符号类型，Variant<int, float> 只占 8 字节
+    VariantUnion<Ts...> union_;
+    variant_index_t<sizeof...(Ts)> index_;
+
+    // 所有候选项都平凡时对应的特殊成员也是平凡的，Variant 整体可以按字节复制 (std::vector 扩容时直接 memcpy)
+    static constexpr bool trivially_destructible = (std::is_trivially_destructible_v<Ts> && ...);
+    static constexpr bool trivially_copy_constructible = (std::is_trivially_copy_constructible_v<Ts> && ...);
+    static constexpr bool trivially_move_constructible = (std::is_trivially_move_constructible_v<Ts> && ...);
+    static constexpr bool trivially_copy_assignable = trivially_destructible && trivially_copy_constructible &&
+                                                      (std::is_trivially_copy_assignable_v<Ts> && ...);
+    static constexpr bool trivially_move_assignable = trivially_destructible && trivially_move_constructible &&
+                                                      (std::is_trivially_move_assignable_v<Ts> && ...);
+
+    // 析构当前的候选项，之后必须立刻构造新的候选项
+    constexpr void destroy() noexcept {
+        variant_dispatch<void, sizeof...(Ts)>(index_, [&](auto I) {
+            using T = typename VariantAlternative<Variant, decltype(I)::value>::type;
+            VariantAccess::get<decltype(I)::value>(*this).~T();
+        });
+    }
+
+    // 构造新候选项时抛出异常: 退回到值初始化的第 0 个候选项，做不到就 terminate，Variant 不会处在没有值的状态
+    constexpr void recover() noexcept {
+        using T0 = typename VariantAlternative<Variant, 0>::type;
+        if constexpr (std::is_nothrow_default_constructible_v<T0>) {
+            std::construct_at(&union_, inPlaceIndex<0>);
+            index_ = 0;
+        } else {
+            std::terminate();
+        }
     }
 
 public:
     template<typename T, std::enable_if_t<(std::is_same_v<T, Ts> || ...), int>  = 0>
-    Variant(T&& value) : index_(VariantIndex<Variant, T>::value) {
-        T *p = reinterpret_cast<T *>(union_);
-        new(p) T(std::forward<T>(value));
-    }
-    Variant() = default;
-    Variant(const Variant &that) = default;
-    Variant &operator=(Variant const &that) noexcept{
-        index_ = that.index_;
-        copy_assigment_functions_table()[index()](union_, that.union_);
+    constexpr Variant(T&& value)
+        : union_(inPlaceIndex<VariantIndex<Variant, T>::value>, std::forward<T>(value)),
+          index_(VariantIndex<Variant, T>::value) {}
+    // 值初始化第 0 个候选项
+    constexpr Variant() noexcept(std::is_nothrow_default_constructible_v<typename VariantAlternative<Variant, 0>::type>)
+        requires std::is_default_constructible_v<typename VariantAlternative<Variant, 0>::type>
+        : union_(inPlaceIndex<0>), index_(0) {}
+    Variant(const Variant &that) requires trivially_copy_constructible = default;
+    constexpr Variant(const Variant &that) : index_(that.index_) {
+        variant_dispatch<void, sizeof...(Ts)>(index_, [&](auto I) {
+            std::construct_at(&union_, inPlaceIndex<decltype(I)::value>, VariantAccess::get<decltype(I)::value>(that));
+        });
+    }
+    Variant &operator=(Variant const &that) requires trivially_copy_assignable = default;
+    // 候选项相同时直接赋值，不同时析构旧的再原地构造新的
+    constexpr Variant &operator=(Variant const &that) {
+        variant_dispatch<void, sizeof...(Ts)>(that.index_, [&](auto I) {
+            constexpr size_t J = decltype(I)::value;
+            if (index_ == J) {
+                VariantAccess::get<J>(*this) = VariantAccess::get<J>(that);
+            } else {
+                emplace<J>(VariantAccess::get<J>(that));
+            }
+        });
         return *this;
     }
-    Variant &operator=(Variant &&that) {
-        index_ = that.index_;
-        move_assigment_functions_table()[index()](union_, that.union_);
+    Variant &operator=(Variant &&that) requires trivially_move_assignable = default;
+    constexpr Variant &operator=(Variant &&that)
+        noexcept(((std::is_nothrow_move_constructible_v<Ts> && std::is_nothrow_move_assignable_v<Ts>) && ...)) {
+        variant_dispatch<void, sizeof...(Ts)>(that.index_, [&](auto I) {
+            constexpr size_t J = decltype(I)::value;
+            if (index_ == J) {
+                VariantAccess::get<J>(*this) = VariantAccess::get<J>(std::move(that));
+            } else {
+                emplace<J>(VariantAccess::get<J>(std::move(that)));
+            }
+        });
         return *this;
     }
-    Variant(Variant &&that) : index_(that.index_) {
-        move_constructors_table()[index()](union_, that.union_);
+    Variant(Variant &&that) requires trivially_move_constructible = default;
+    constexpr Variant(Variant &&that) : index_(that.index_) {
+        variant_dispatch<void, sizeof...(Ts)>(index_, [&](auto I) {
+            std::construct_at(&union_, inPlaceIndex<decltype(I)::value>,
+                              VariantAccess::get<decltype(I)::value>(std::move(that)));
+        });
     }
 
-    ~Variant() noexcept {
-        destructors_table()[index()](union_);
+    ~Variant() requires trivially_destructible = default;
+    constexpr ~Variant() noexcept {
+        destroy();
     }
 
     template <size_t I, typename ...Args>
-    explicit Variant(InPlaceIndex<I>, Args &&...value_args) : index_(I) {
-        new (union_) typename VariantAlternative<Variant, I>::type
-            (std::forward<Args>(value_args)...);
+    constexpr explicit Variant(InPlaceIndex<I>, Args &&...value_args)
+        : union_(inPlaceIndex<I>, std::forward<Args>(value_args)...), index_(I) {}
+
+    // 析构旧的候选项，在原地构造第 I 个候选项，不产生临时的 Variant 或临时的候选项
+    template<size_t I, typename... Args>
+    constexpr typename VariantAlternative<Variant, I>::type &emplace(Args &&...args) {
+        static_assert(I < sizeof...(Ts), "I out of range!");
+        destroy();
+        try {
+            std::construct_at(&union_, inPlaceIndex<I>, std::forward<Args>(args)...);
+        } catch (...) {
+            recover();
+            throw;
+        }
+        index_ = I;
+        return VariantAccess::get<I>(*this);
+    }
+
+    template<typename T, typename... Args>
+    constexpr T &emplace(Args &&...args) {
+        return emplace<VariantIndex<Variant, T>::value>(std::forward<Args>(args)...);
     }
 
     template <class Lambda>
-    std::common_type<typename std::invoke_result<Lambda, Ts &>::type...>::type visit(Lambda &&lambda) {
-        return visitors_table<Lambda>()[index()](union_, std::forward<Lambda>(lambda));
+    constexpr std::common_type<typename std::invoke_result<Lambda, Ts &>::type...>::type visit(Lambda &&lambda) {
+        using R = std::common_type<typename std::invoke_result<Lambda, Ts &>::type...>::type;
+        return variant_dispatch<R, sizeof...(Ts)>(index_, [&](auto I) -> R {
+            return std::invoke(std::forward<Lambda>(lambda), VariantAccess::get<decltype(I)::value>(*this));
+        });
+    }
+
+    // 返回类型推迟到选中之后再推导，否则非 const 对象调用 visit 时也会用 Ts const & 实例化访问者
+    template <class Lambda>
+    constexpr decltype(auto) visit(Lambda &&lambda) const {
+        using R = std::common_type<typename std::invoke_result<Lambda, Ts const &>::type...>::type;
+        return variant_dispatch<R, sizeof...(Ts)>(index_, [&](auto I) -> R {
+            return std::invoke(std::forward<Lambda>(lambda), VariantAccess::get<decltype(I)::value>(*this));
+        });
     }
 
     constexpr size_t index() const noexcept {
@@ -150,61 +281,113 @@ public:
     }
 
     template<size_t I>
-    typename VariantAlternative<Variant, I>::type &get() {
+    constexpr typename VariantAlternative<Variant, I>::type &get() {
         static_assert(I < sizeof...(Ts), "I out of range!");
         if (index_ != I)
             throw BadVariantAccess();
-        return *reinterpret_cast<typename VariantAlternative<Variant, I>::type *>(union_);
+        return VariantAccess::get<I>(*this);
     }
 
     template<typename T>
-    T &get() {
+    constexpr T &get() {
         return get<VariantIndex<Variant, T>::value>();
     }
 
     template<size_t I>
-    typename VariantAlternative<Variant, I>::type const &get() const {
+    constexpr typename VariantAlternative<Variant, I>::type const &get() const {
         static_assert(I < sizeof...(Ts), "I out of range!");
         if (index_ != I)
             throw BadVariantAccess();
-        return *reinterpret_cast<typename VariantAlternative<Variant, I>::type const *>(union_);
+        return VariantAccess::get<I>(*this);
     }
 
     template<typename T>
-    T const &get() const {
+    constexpr T const &get() const {
         return get<VariantIndex<Variant, T>::value>();
     }
 
     template<size_t I>
-    typename VariantAlternative<Variant, I>::type *get_if() {
+    constexpr typename VariantAlternative<Variant, I>::type *get_if() {
         static_assert(I < sizeof...(Ts), "I out of range!");
         if (index_ != I)
             return nullptr;
-        return reinterpret_cast<typename VariantAlternative<Variant, I>::type *>(union_);
+        return std::addressof(VariantAccess::get<I>(*this));
     }
 
     template<typename T>
-    T *get_if() {
+    constexpr T *get_if() {
         return get_if<VariantIndex<Variant, T>::value>();
     }
 
     template<size_t I>
-    typename VariantAlternative<Variant, I>::type const *get_if() const {
+    constexpr typename VariantAlternative<Variant, I>::type const *get_if() const {
         static_assert(I < sizeof...(Ts), "I out of range!");
         if (index_ != I)
             return nullptr;
-        return reinterpret_cast<typename VariantAlternative<Variant, I>::type const *>(union_);
+        return std::addressof(VariantAccess::get<I>(*this));
     }
 
     template<typename T>
-    T const *get_if() const {
+    constexpr T const *get_if() const {
         return get_if<VariantIndex<Variant, T>::value>();
     }
 };
 
-template<typename Fn,typename...Ts>
-auto Visit(Fn &&fn,Variant<Ts...> &variant) {
-    return variant.visit(std::forward<Fn>(fn));
+template<typename... Ts>
+struct VariantSize<Variant<Ts...> > : std::integral_constant<size_t, sizeof...(Ts)> {};
+
+template<typename V>
+struct VariantSize<V const> : VariantSize<V> {};
+
+template<typename V>
+struct IsVariant : std::false_type {};
+
+template<typename... Ts>
+struct IsVariant<Variant<Ts...> > : std::true_type {};
+
+// 多个 Variant 的下标按行优先压成一个下标: flat = (i0 * N1 + i1) * N2 + i2 ...
+template<typename... Vs>
+struct VariantFlatIndex {
+    static constexpr size_t sizes[] = {VariantSize<std::remove_cvref_t<Vs> >::value...};
+    static constexpr size_t total = (size_t(1) * ... * VariantSize<std::remove_cvref_t<Vs> >::value);
+
+    // 第 K 个 Variant 在 flat 中的下标
+    static constexpr size_t index_of(size_t flat, size_t k) {
+        size_t stride = 1;
+        for (size_t j = k + 1; j < sizeof...(Vs); ++j) {
+            stride *= sizes[j];
+        }
+        return flat / stride % sizes[k];
+    }
+
+    static constexpr size_t flatten(Vs const &...vs) noexcept {
+        size_t flat = 0;
+        ((flat = flat * VariantSize<std::remove_cvref_t<Vs> >::value + vs.index()), ...);
+        return flat;
+    }
+};
+
+template<size_t F, typename Fn, typename... Vs, size_t... Ks>
+constexpr decltype(auto) variant_visit_at(std::index_sequence<Ks...>, Fn &&fn, Vs &&...vs) {
+    using Flat = VariantFlatIndex<Vs...>;
+    return std::invoke(std::forward<Fn>(fn),
+                       VariantAccess::get<Flat::index_of(F, Ks)>(std::forward<Vs>(vs))...);
+}
+
+template<typename Fn, typename... Vs, size_t... Fs>
+auto variant_visit_result(std::index_sequence<Fs...>)
+    -> std::common_type_t<decltype(variant_visit_at<Fs>(std::index_sequence_for<Vs...>{},
+                                                        std::declval<Fn>(), std::declval<Vs>()...))...>;
+
+// Visit(f, v1, v2, ...): 笛卡尔积上只做一次分派，v 可以是 const 或右值，右值的候选项以右值传给 f
+template<typename Fn, typename... Vs, std::enable_if_t<(IsVariant<std::remove_cvref_t<Vs> >::value && ...), int> = 0>
+constexpr decltype(auto) Visit(Fn &&fn, Vs &&...vs) {
+    using Flat = VariantFlatIndex<Vs...>;
+    using R = decltype(variant_visit_result<Fn, Vs...>(std::make_index_sequence<Flat::total>{}));
+    return variant_dispatch<R, Flat::total>(Flat::flatten(vs...), [&](auto F) -> R {
+        return variant_visit_at<decltype(F)::value>(std::index_sequence_for<Vs...>{},
+                                                    std::forward<Fn>(fn), std::forward<Vs>(vs)...);
+    });
 }
 
 template<typename T, typename... Ts>
@@ -0,0 +1,195 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 候选项都可以按字节复制的 Variant 的二进制编码，解码时不复制
+/*
+ * 1. 一条记录: 1 字节的下标，补齐到该候选项的对齐，然后是候选项的原始字节；记录之间紧挨着，没有长度头
+ * 2. 补齐是相对缓冲区起点算的，所以缓冲区起点必须按 VariantCodec::alignment 对齐 (std::vector 的内存满足)
+ * 3. VariantView 直接在缓冲区上读下标、把载荷当成候选项的引用，不构造 Variant；load() 才复制出一个 Variant
+ * 4. 原始字节意味着两端必须是相同的 ABI (字节序、类型布局)，这里不做转换
+ * 5. 解码时检查下标和长度，坏的记录抛出 BadVariantEncoding
+ */
+#ifndef VARIANT_SERIALIZE_HPP
+#define VARIANT_SERIALIZE_HPP
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "Variant.hpp"
+
+struct BadVariantEncoding : std::exception {
+    BadVariantEncoding() = default;
+
+    virtual ~BadVariantEncoding() = default;
+
+    const char *what() const noexcept override {
+        return "BadVariantEncoding";
+    }
+};
+
+template<typename... Ts>
+struct VariantCodec {
+    static_assert((std::is_trivially_copyable_v<Ts> && ...), "alternatives must be trivially copyable");
+    static_assert(sizeof...(Ts) <= 256, "index must fit in one byte");
+
+    static constexpr size_t alignment = std::max({alignof(Ts)...});
+    static_assert(alignment <= alignof(std::max_align_t), "over-aligned alternatives are not supported");
+
+    static constexpr size_t sizes[] = {sizeof(Ts)...};
+    static constexpr size_t aligns[] = {alignof(Ts)...};
+
+    static constexpr size_t payload_offset(size_t offset, size_t index) noexcept {
+        return (offset + 1 + aligns[index] - 1) / aligns[index] * aligns[index];
+    }
+
+    // 从 offset 开始的一条下标为 index 的记录结束的位置
+    static constexpr size_t record_end(size_t offset, size_t index) noexcept {
+        return payload_offset(offset, index) + sizes[index];
+    }
+
+    // 把 v 写到 base + offset，补齐的字节写 0，返回记录结束的位置
+    static size_t write(Variant<Ts...> const &v, std::byte *base, size_t offset) noexcept {
+        size_t const index = v.index();
+        size_t const payload = payload_offset(offset, index);
+        base[offset] = static_cast<std::byte>(index);
+        std::memset(base + offset + 1, 0, payload - offset - 1);
+        v.visit([&](auto const &value) {
+            std::memcpy(base + payload, &value, sizeof(value));
+        });
+        return payload + sizes[index];
+    }
+};
+
+// 追加一条记录
+template<typename... Ts>
+void encodeVariant(Variant<Ts...> const &v, std::vector<std::byte> &out) {
+    using Codec = VariantCodec<Ts...>;
+    size_t const offset = out.size();
+    out.resize(Codec::record_end(offset, v.index()));
+    Codec::write(v, out.data(), offset);
+}
+
+// 先算出总长度，只扩容一次
+template<typename... Ts>
+void encodeVariants(std::span<Variant<Ts...> const> vs, std::vector<std::byte> &out) {
+    using Codec = VariantCodec<Ts...>;
+    size_t end = out.size();
+    for (Variant<Ts...> const &v: vs) {
+        end = Codec::record_end(end, v.index());
+    }
+    size_t offset = out.size();
+    out.resize(end);
+    for (Variant<Ts...> const &v: vs) {
+        offset = Codec::write(v, out.data(), offset);
+    }
+}
+
+template<typename... Ts>
+void encodeVariants(std::span<Variant<Ts...> > vs, std::vector<std::byte> &out) {
+    encodeVariants(std::span<Variant<Ts...> const>(vs), out);
+}
+
+// 缓冲区里一条记录的只读视图，缓冲区必须比视图活得久
+template<typename... Ts>
+class VariantView {
+    using Codec = VariantCodec<Ts...>;
+    using Value = Variant<Ts...>;
+
+    std::byte const *payload_;
+    size_t index_;
+    size_t end_;
+
+    template<size_t I>
+    typename VariantAlternative<Value, I>::type const &ref() const noexcept {
+        using T = typename VariantAlternative<Value, I>::type;
+        return *std::launder(reinterpret_cast<T const *>(payload_));
+    }
+
+public:
+    // 解析 bytes 中从 offset 开始的一条记录
+    explicit VariantView(std::span<std::byte const> bytes, size_t offset = 0) {
+        if (reinterpret_cast<std::uintptr_t>(bytes.data()) % Codec::alignment != 0 || offset >= bytes.size())
+            throw BadVariantEncoding();
+        index_ = static_cast<size_t>(bytes[offset]);
+        if (index_ >= sizeof...(Ts))
+            throw BadVariantEncoding();
+        end_ = Codec::record_end(offset, index_);
+        if (end_ > bytes.size())
+            throw BadVariantEncoding();
+        payload_ = bytes.data() + Codec::payload_offset(offset, index_);
+    }
+
+    size_t index() const noexcept {
+        return index_;
+    }
+
+    // 下一条记录的位置
+    size_t next() const noexcept {
+        return end_;
+    }
+
+    template<typename T>
+    bool holds_alternative() const noexcept {
+        return VariantIndex<Value, T>::value == index_;
+    }
+
+    template<size_t I>
+    typename VariantAlternative<Value, I>::type const &get() const {
+        static_assert(I < sizeof...(Ts), "I out of range!");
+        if (index_ != I)
+            throw BadVariantAccess();
+        return ref<I>();
+    }
+
+    template<typename T>
+    T const &get() const {
+        return get<VariantIndex<Value, T>::value>();
+    }
+
+    template<size_t I>
+    typename VariantAlternative<Value, I>::type const *get_if() const noexcept {
+        static_assert(I < sizeof...(Ts), "I out of range!");
+        if (index_ != I)
+            return nullptr;
+        return &ref<I>();
+    }
+
+    template<typename T>
+    T const *get_if() const noexcept {
+        return get_if<VariantIndex<Value, T>::value>();
+    }
+
+    template<class Lambda>
+    decltype(auto) visit(Lambda &&lambda) const {
+        using R = std::common_type_t<std::invoke_result_t<Lambda, Ts const &>...>;
+        return variant_dispatch<R, sizeof...(Ts)>(index_, [&](auto I) -> R {
+            return std::invoke(std::forward<Lambda>(lambda), ref<decltype(I)::value>());
+        });
+    }
+
+    Value load() const noexcept {
+        return variant_dispatch<Value, sizeof...(Ts)>(index_, [&](auto I) {
+            return Value(inPlaceIndex<decltype(I)::value>, ref<decltype(I)::value>());
+        });
+    }
+};
+
+// 依次解码到 out，直到 out 填满或 bytes 用完，返回解码的个数
+template<typename... Ts>
+size_t decodeVariants(std::span<std::byte const> bytes, std::span<Variant<Ts...> > out) {
+    size_t offset = 0;
+    size_t count = 0;
+    while (count < out.size() && offset < bytes.size()) {
+        VariantView<Ts...> view(bytes, offset);
+        out[count++] = view.load();
+        offset = view.next();
+    }
+    return count;
+}
+
+#endif //VARIANT_SERIALIZE_HPP
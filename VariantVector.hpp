@@ -0,0 +1,263 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 按候选项分列存储的 Variant 数组 (struct of arrays)
+/*
+ * 1. 每个候选项类型有自己的连续数组，元素不再按最大的候选项占位
+ * 2. tags_ 记录每个位置的候选项下标 (variant_index_t，通常 1 字节)，slots_ 记录它在所属数组中的位置
+ * 3. visit_all(f) 按类型逐列调用 f，每列是一个没有分派的紧凑循环，编译器可以向量化；元素之间的顺序不保证
+ * 4. 按插入顺序遍历时，operator[] 和迭代器给出 Ref 代理，可以 visit / get，也可以 load() 成一个 Variant
+ */
+#ifndef VARIANT_VECTOR_HPP
+#define VARIANT_VECTOR_HPP
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Variant.hpp"
+
+template<typename... Ts>
+class VariantVector {
+public:
+    using value_type = Variant<Ts...>;
+    using size_type = size_t;
+    using slot_type = std::uint32_t;   // 单列最多 2^32 - 1 个元素
+
+    template<size_t I>
+    using alternative_t = typename VariantAlternative<value_type, I>::type;
+
+private:
+    std::tuple<std::vector<Ts>...> columns_;
+    std::vector<variant_index_t<sizeof...(Ts)> > tags_;
+    std::vector<slot_type> slots_;
+
+    template<size_t I>
+    void append_slot() {
+        size_t const slot = std::get<I>(columns_).size() - 1;
+        if (slot > std::numeric_limits<slot_type>::max()) {
+            std::get<I>(columns_).pop_back();
+            throw std::length_error("VariantVector column too long");
+        }
+        try {
+            tags_.push_back(I);
+            slots_.push_back(static_cast<slot_type>(slot));
+        } catch (...) {
+            if (tags_.size() > slots_.size()) {
+                tags_.pop_back();
+            }
+            std::get<I>(columns_).pop_back();
+            throw;
+        }
+    }
+
+    template<bool Const>
+    class Ref {
+        using Owner = std::conditional_t<Const, VariantVector const, VariantVector>;
+        Owner *owner_;
+        size_t pos_;
+
+    public:
+        Ref(Owner *owner, size_t pos) noexcept : owner_(owner), pos_(pos) {}
+
+        size_t index() const noexcept {
+            return owner_->tags_[pos_];
+        }
+
+        template<typename T>
+        bool holds_alternative() const noexcept {
+            return VariantIndex<value_type, T>::value == index();
+        }
+
+        template<size_t I>
+        decltype(auto) get() const {
+            if (index() != I)
+                throw BadVariantAccess();
+            return std::get<I>(owner_->columns_)[owner_->slots_[pos_]];
+        }
+
+        template<typename T>
+        decltype(auto) get() const {
+            return get<VariantIndex<value_type, T>::value>();
+        }
+
+        template<class Lambda>
+        decltype(auto) visit(Lambda &&lambda) const {
+            using R = std::common_type_t<std::invoke_result_t<
+                Lambda, std::conditional_t<Const, Ts const &, Ts &> >...>;
+            size_t const slot = owner_->slots_[pos_];
+            return variant_dispatch<R, sizeof...(Ts)>(index(), [&](auto I) -> R {
+                return std::invoke(std::forward<Lambda>(lambda),
+                                   std::get<decltype(I)::value>(owner_->columns_)[slot]);
+            });
+        }
+
+        // 复制出一个独立的 Variant
+        value_type load() const {
+            return visit([](auto const &value) {
+                return value_type(inPlaceIndex<VariantIndex<value_type, std::remove_cvref_t<decltype(value)> >::value>,
+                                  value);
+            });
+        }
+    };
+
+    template<bool Const>
+    class Iter {
+        using Owner = std::conditional_t<Const, VariantVector const, VariantVector>;
+        Owner *owner_ = nullptr;
+        size_t pos_ = 0;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Ref<Const>;
+        using difference_type = std::ptrdiff_t;
+        using reference = Ref<Const>;
+
+        Iter() = default;
+        Iter(Owner *owner, size_t pos) noexcept : owner_(owner), pos_(pos) {}
+
+        reference operator*() const noexcept {
+            return reference(owner_, pos_);
+        }
+        Iter &operator++() noexcept {
+            ++pos_;
+            return *this;
+        }
+        Iter operator++(int) noexcept {
+            Iter tmp = *this;
+            ++pos_;
+            return tmp;
+        }
+        bool operator==(Iter const &that) const noexcept {
+            return pos_ == that.pos_;
+        }
+        bool operator!=(Iter const &that) const noexcept {
+            return pos_ != that.pos_;
+        }
+    };
+
+public:
+    using reference = Ref<false>;
+    using const_reference = Ref<true>;
+    using iterator = Iter<false>;
+    using const_iterator = Iter<true>;
+
+    VariantVector() = default;
+
+    size_t size() const noexcept {
+        return tags_.size();
+    }
+
+    bool empty() const noexcept {
+        return tags_.empty();
+    }
+
+    // 只能为下标列预留；各列的长度取决于每种类型的个数
+    void reserve(size_t n) {
+        tags_.reserve(n);
+        slots_.reserve(n);
+    }
+
+    void clear() noexcept {
+        std::apply([](auto &...columns) { (columns.clear(), ...); }, columns_);
+        tags_.clear();
+        slots_.clear();
+    }
+
+    template<size_t I, typename... Args>
+    alternative_t<I> &emplace_back(Args &&...args) {
+        auto &column = std::get<I>(columns_);
+        column.emplace_back(std::forward<Args>(args)...);
+        append_slot<I>();
+        return column.back();
+    }
+
+    template<typename T, std::enable_if_t<(std::is_same_v<std::remove_cvref_t<T>, Ts> || ...), int> = 0>
+    void push_back(T &&value) {
+        emplace_back<VariantIndex<value_type, std::remove_cvref_t<T> >::value>(std::forward<T>(value));
+    }
+
+    void push_back(value_type const &value) {
+        Visit([this](auto const &alt) { this->push_back(alt); }, value);
+    }
+
+    // 最后插入的元素一定在它所属列的末尾
+    void pop_back() noexcept {
+        variant_dispatch<void, sizeof...(Ts)>(tags_.back(), [&](auto I) {
+            std::get<decltype(I)::value>(columns_).pop_back();
+        });
+        tags_.pop_back();
+        slots_.pop_back();
+    }
+
+    reference operator[](size_t pos) noexcept {
+        return reference(this, pos);
+    }
+
+    const_reference operator[](size_t pos) const noexcept {
+        return const_reference(this, pos);
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+    iterator end() noexcept {
+        return iterator(this, size());
+    }
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const noexcept {
+        return const_iterator(this, size());
+    }
+
+    // 第 I 种候选项的所有元素，按插入顺序连续存放
+    template<size_t I>
+    std::vector<alternative_t<I> > &column() noexcept {
+        return std::get<I>(columns_);
+    }
+
+    template<size_t I>
+    std::vector<alternative_t<I> > const &column() const noexcept {
+        return std::get<I>(columns_);
+    }
+
+    template<typename T>
+    std::vector<T> &column() noexcept {
+        return std::get<VariantIndex<value_type, T>::value>(columns_);
+    }
+
+    template<typename T>
+    std::vector<T> const &column() const noexcept {
+        return std::get<VariantIndex<value_type, T>::value>(columns_);
+    }
+
+    // 逐列调用 f，没有逐元素的分派
+    template<class Fn>
+    void visit_all(Fn &&fn) {
+        std::apply([&](auto &...columns) {
+            ([&] {
+                for (auto &value: columns) {
+                    fn(value);
+                }
+            }(), ...);
+        }, columns_);
+    }
+
+    template<class Fn>
+    void visit_all(Fn &&fn) const {
+        std::apply([&](auto const &...columns) {
+            ([&] {
+                for (auto const &value: columns) {
+                    fn(value);
+                }
+            }(), ...);
+        }, columns_);
+    }
+};
+
+#endif //VARIANT_VECTOR_HPP
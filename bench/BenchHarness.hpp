@@ -0,0 +1,210 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// bench/ 下的基准共用的计时、参数和输出
+/*
+ * 1. bestNsPerOp: 重复 rounds 次取最快的一次；setup 在每次计时之前运行，不计入耗时
+ *    bestNsPerOpThreads: 同上，但 body(t) 在 threads 个线程上同时开始，线程的创建不计入耗时；
+ *    ops 是每个线程的操作数，结果是每个线程上一次操作的墙钟时间
+ * 2. BenchReport: 结果按行收集，默认边跑边输出 CSV；命令行带 --json 时结束后输出一个 JSON 数组，方便不同版本之间 diff
+ * 3. ZipfKeys: 按 Zipf 分布在 [0, n) 中取下标，s 越大越集中在前面的下标
+ * 4. benchKeep: 阻止编译器把结果未被使用的计算删掉或提到循环外
+ */
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<class T>
+inline void benchKeep(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static T const *volatile sink;
+    sink = &value;
+#endif
+}
+
+inline bool benchFlag(int argc, char **argv, char const *name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// --name value
+inline std::size_t benchOption(int argc, char **argv, char const *name, std::size_t fallback) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return std::strtoull(argv[i + 1], nullptr, 10);
+        }
+    }
+    return fallback;
+}
+
+template<class Setup, class Body>
+double bestNsPerOp(std::size_t ops, int rounds, Setup setup, Body body) {
+    double best = 1e300;
+    for (int r = 0; r < rounds; ++r) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / double(std::max<std::size_t>(ops, 1)));
+    }
+    return best;
+}
+
+template<class Body>
+double bestNsPerOp(std::size_t ops, int rounds, Body body) {
+    return bestNsPerOp(ops, rounds, [] {}, body);
+}
+
+template<class Setup, class Body>
+double bestNsPerOpThreads(std::size_t ops, int rounds, unsigned threads, Setup setup, Body body) {
+    double best = 1e300;
+    for (int r = 0; r < rounds; ++r) {
+        setup();
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                body(t);
+            });
+        }
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &w: workers) {
+            w.join();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count() / double(std::max<std::size_t>(ops, 1)));
+    }
+    return best;
+}
+
+template<class Body>
+double bestNsPerOpThreads(std::size_t ops, int rounds, unsigned threads, Body body) {
+    return bestNsPerOpThreads(ops, rounds, threads, [] {}, body);
+}
+
+class BenchReport {
+    struct Field {
+        std::string text;
+        bool numeric;
+    };
+
+    std::vector<std::string> columns_;
+    std::vector<std::vector<Field> > rows_;
+    bool json_;
+
+    static Field field(char const *value) {
+        return {value, false};
+    }
+    static Field field(std::string const &value) {
+        return {value, false};
+    }
+    template<class T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    static Field field(T value) {
+        return {std::to_string(value), true};
+    }
+    static Field field(double value) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.2f", value);
+        return {buf, true};
+    }
+
+    void printCsv(std::vector<Field> const &row) const {
+        for (std::size_t i = 0; i < row.size(); ++i) {
+            std::printf(i == 0 ? "%s" : ",%s", row[i].text.c_str());
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+public:
+    BenchReport(int argc, char **argv, std::vector<std::string> columns)
+        : columns_(std::move(columns)), json_(benchFlag(argc, argv, "--json")) {
+        if (!json_) {
+            std::vector<Field> header;
+            for (std::string const &c: columns_) {
+                header.push_back({c, false});
+            }
+            printCsv(header);
+        }
+    }
+
+    BenchReport(BenchReport &&) = delete;
+
+    // JSON 在析构时一次输出
+    ~BenchReport() {
+        if (!json_) {
+            return;
+        }
+        std::printf("[\n");
+        for (std::size_t r = 0; r < rows_.size(); ++r) {
+            std::printf("  {");
+            for (std::size_t i = 0; i < rows_[r].size(); ++i) {
+                Field const &f = rows_[r][i];
+                std::printf(f.numeric ? "%s\"%s\": %s" : "%s\"%s\": \"%s\"", i == 0 ? "" : ", ",
+                            columns_[i].c_str(), f.text.c_str());
+            }
+            std::printf(r + 1 == rows_.size() ? "}\n" : "},\n");
+        }
+        std::printf("]\n");
+    }
+
+    template<class... Values>
+    void add(Values const &...values) {
+        static_assert(sizeof...(Values) > 0);
+        std::vector<Field> row{field(values)...};
+        if (json_) {
+            rows_.push_back(std::move(row));
+        } else {
+            printCsv(row);
+        }
+    }
+};
+
+// 预先算好累积分布，取样时二分查找
+class ZipfKeys {
+    std::vector<double> cdf_;
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+
+public:
+    explicit ZipfKeys(std::size_t n, double s = 0.99) : cdf_(n) {
+        double sum = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(double(i + 1), s);
+            cdf_[i] = sum;
+        }
+        for (double &c: cdf_) {
+            c /= sum;
+        }
+    }
+
+    template<class Rng>
+    std::size_t operator()(Rng &rng) {
+        auto it = std::lower_bound(cdf_.begin(), cdf_.end(), uniform_(rng));
+        return std::min<std::size_t>(it - cdf_.begin(), cdf_.size() - 1);
+    }
+};
+
+#endif //BENCH_HARNESS_HPP
@@ -0,0 +1,90 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 读多写少的配置发布：AtomicSharedPtr 与 "SharedPtr + std::mutex" 的读耗时对比
+// 一个写线程每隔一段时间发布新配置，其余线程不停地 load；readers 从 1 到 --max-threads (默认取核数与 8 的较大者)
+// 输出 holder,readers,ns_per_op；默认 CSV，--json 输出 JSON；ns_per_op 是每个读线程上一次 load 的墙钟时间
+#include "BenchHarness.hpp"
+#include <AtomicSharedPtr.hpp>
+#include <SmartPtr.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+constexpr int kReadsPerThread = 1000000;
+constexpr int kRounds = 3;
+
+struct Config {
+    long version = 0;
+};
+
+struct LockedConfig {
+    std::mutex mtx;
+    SharedPtr<Config> cfg = makeShared<Config>();
+
+    SharedPtr<Config> load() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return cfg;
+    }
+
+    void store(SharedPtr<Config> next) {
+        std::lock_guard<std::mutex> lock(mtx);
+        cfg = std::move(next);
+    }
+};
+
+struct LockFreeConfig {
+    AtomicSharedPtr<Config> cfg{makeShared<Config>()};
+
+    SharedPtr<Config> load() {
+        return cfg.load();
+    }
+
+    void store(SharedPtr<Config> next) {
+        cfg.store(std::move(next));
+    }
+};
+
+// 线程 readers 是写线程，读线程全部结束后它也随即退出
+template<class Holder>
+double run(unsigned readers) {
+    std::optional<Holder> holder;
+    std::atomic<unsigned> done{0};
+    auto setup = [&] {
+        holder.reset();
+        holder.emplace();
+        done.store(0, std::memory_order_relaxed);
+    };
+    return bestNsPerOpThreads(kReadsPerThread, kRounds, readers + 1, setup, [&](unsigned t) {
+        if(t == readers) {
+            long version = 0;
+            while(done.load(std::memory_order_acquire) < readers) {
+                auto next = makeShared<Config>();
+                next->version = ++version;
+                holder->store(std::move(next));
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            return;
+        }
+        long sum = 0;
+        for(int i = 0; i < kReadsPerThread; ++i) {
+            sum += holder->load()->version;
+        }
+        benchKeep(sum);
+        done.fetch_add(1, std::memory_order_release);
+    });
+}
+
+int main(int argc, char **argv) {
+    unsigned const hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned const max_readers = unsigned(benchOption(argc, argv, "--max-threads", std::max(hw, 8u)));
+    BenchReport report(argc, argv, {"holder", "readers", "ns_per_op"});
+    for(unsigned readers = 1; readers <= max_readers; readers *= 2) {
+        report.add("AtomicSharedPtr", readers, run<LockFreeConfig>(readers));
+        report.add("SharedPtr+mutex", readers, run<LockedConfig>(readers));
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// ConcurrentSet 与 "Map + std::mutex" 的吞吐对比
+// 输出 container,threads,ns_per_op；默认 CSV，--json 输出 JSON
+// ns_per_op 是每个线程上一次操作的墙钟时间，threads 从 1 到 --max-threads (默认取核数与 32 的较大者)
+#include "BenchHarness.hpp"
+#include <ConcurrentSkipList.hpp>
+#include <Map.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+
+constexpr int kKeyRange = 1 << 16;
+constexpr int kOpsPerThread = 200000;
+constexpr int kRounds = 3;
+
+struct LockedMap {
+    std::mutex mtx;
+    Map<int, int> map;
+
+    void insert(int key) {
+        std::lock_guard<std::mutex> lock(mtx);
+        map.insert({key, key});
+    }
+
+    void erase(int key) {
+        std::lock_guard<std::mutex> lock(mtx);
+        map.erase(key);
+    }
+
+    bool contains(int key) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return map.contains(key);
+    }
+};
+
+struct LockFreeSet {
+    ConcurrentSet<int> set;
+
+    void insert(int key) {
+        set.insert(key);
+    }
+
+    void erase(int key) {
+        set.erase(key);
+    }
+
+    bool contains(int key) {
+        return set.contains(key);
+    }
+};
+
+// 写多读少: 40% 插入, 40% 删除, 20% 查找
+template<class Container>
+double run(unsigned threads) {
+    std::optional<Container> c;
+    std::atomic<long> sink{0};
+    auto setup = [&] {
+        c.reset();
+        c.emplace();
+        for (int i = 0; i < kKeyRange; i += 2) {
+            c->insert(i);
+        }
+    };
+    double ns = bestNsPerOpThreads(kOpsPerThread, kRounds, threads, setup, [&](unsigned t) {
+        std::mt19937 rng(t * 7919 + 1);
+        std::uniform_int_distribution<int> key(0, kKeyRange - 1);
+        std::uniform_int_distribution<int> op(0, 9);
+        long hits = 0;
+        for (int i = 0; i < kOpsPerThread; ++i) {
+            int k = key(rng);
+            int o = op(rng);
+            if (o < 4) {
+                c->insert(k);
+            } else if (o < 8) {
+                c->erase(k);
+            } else {
+                hits += c->contains(k);
+            }
+        }
+        sink.fetch_add(hits, std::memory_order_relaxed);
+    });
+    benchKeep(sink);
+    return ns;
+}
+
+int main(int argc, char **argv) {
+    unsigned const hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned const max_threads = unsigned(benchOption(argc, argv, "--max-threads", std::max(hw, 32u)));
+    BenchReport report(argc, argv, {"container", "threads", "ns_per_op"});
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        report.add("ConcurrentSet", threads, run<LockFreeSet>(threads));
+        report.add("Map+mutex", threads, run<LockedMap>(threads));
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// Map / Set / MultiSet 与 std::map / std::set / std::multiset 的常用操作耗时对比
+// 输出 container,op,dist,size,ns_per_op；默认 CSV，--json 输出 JSON
+// 规模从 1e3 到 --max-size (默认 1e6，最大跑到 1e7 要几分钟)，键的分布有 sequential / random / zipf
+// 插入的键都是偶数，find_miss 用相邻的奇数；scan 是 lower_bound 之后向后走 16 个元素
+#include "BenchHarness.hpp"
+#include <Map.hpp>
+#include <Set.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+constexpr std::size_t kScanLength = 16;
+constexpr std::size_t kSizeCalls = 10;
+
+template<class C>
+constexpr bool is_map_v = requires { typename C::mapped_type; };
+
+template<class C>
+void insertKey(C &c, long key) {
+    if constexpr (is_map_v<C>) {
+        c.insert({key, key});
+    } else {
+        c.insert(key);
+    }
+}
+
+template<class V>
+long keyOf(V const &value) {
+    if constexpr (requires { value.first; }) {
+        return value.first;
+    } else {
+        return value;
+    }
+}
+
+// Map::lower_bound 只接受 value_type，比较器只看 first
+template<class C>
+auto lowerBound(C const &c, long key) {
+    if constexpr (requires { c.lower_bound(key); }) {
+        return c.lower_bound(key);
+    } else {
+        return c.lower_bound({key, 0});
+    }
+}
+
+struct Workload {
+    char const *dist;
+    std::vector<long> inserts;  // 按插入的顺序
+    std::vector<long> lookups;  // 打乱的已插入的键
+};
+
+Workload makeWorkload(char const *dist, std::size_t n, std::mt19937_64 &rng) {
+    Workload w{dist, std::vector<long>(n), {}};
+    for (std::size_t i = 0; i < n; ++i) {
+        w.inserts[i] = long(i) * 2;
+    }
+    if (dist[0] == 'r') {
+        std::shuffle(w.inserts.begin(), w.inserts.end(), rng);
+    } else if (dist[0] == 'z') {
+        // 热门的键分散在整个键空间里，而不是集中在最小的几个
+        std::vector<long> keys = w.inserts;
+        std::shuffle(keys.begin(), keys.end(), rng);
+        ZipfKeys zipf(n);
+        for (long &k: w.inserts) {
+            k = keys[zipf(rng)];
+        }
+    }
+    w.lookups = w.inserts;
+    std::shuffle(w.lookups.begin(), w.lookups.end(), rng);
+    return w;
+}
+
+template<class C>
+void runContainer(BenchReport &report, char const *name, Workload const &w, int rounds) {
+    std::size_t const n = w.inserts.size();
+    C c;
+    C work;
+    auto add = [&](char const *op, double ns) {
+        report.add(name, op, w.dist, n, ns);
+    };
+
+    add("insert", bestNsPerOp(n, rounds, [&] { c.clear(); }, [&] {
+        for (long k: w.inserts) {
+            insertKey(c, k);
+        }
+    }));
+    C const &cc = c;
+    add("find_hit", bestNsPerOp(n, rounds, [&] {
+        std::size_t found = 0;
+        for (long k: w.lookups) {
+            found += cc.find(k) != cc.end();
+        }
+        benchKeep(found);
+    }));
+    add("find_miss", bestNsPerOp(n, rounds, [&] {
+        std::size_t found = 0;
+        for (long k: w.lookups) {
+            found += cc.find(k + 1) != cc.end();
+        }
+        benchKeep(found);
+    }));
+    std::size_t const probes = std::max<std::size_t>(n / kScanLength, 1);
+    add("scan", bestNsPerOp(probes, rounds, [&] {
+        long sum = 0;
+        for (std::size_t i = 0; i < probes; ++i) {
+            auto it = lowerBound(cc, w.lookups[i]);
+            for (std::size_t j = 0; j < kScanLength && it != cc.end(); ++j, ++it) {
+                sum += keyOf(*it);
+            }
+        }
+        benchKeep(sum);
+    }));
+    add("iterate", bestNsPerOp(cc.size(), rounds, [&] {
+        long sum = 0;
+        for (auto const &value: cc) {
+            sum += keyOf(value);
+        }
+        benchKeep(sum);
+    }));
+    // size() 的代价可能和元素个数有关，只调用固定的次数
+    add("size", bestNsPerOp(kSizeCalls, rounds, [&] {
+        for (std::size_t i = 0; i < kSizeCalls; ++i) {
+            std::size_t size = cc.size();
+            benchKeep(size);
+        }
+    }));
+    add("copy", bestNsPerOp(cc.size(), rounds, [&] { work.clear(); }, [&] {
+        work = cc;
+    }));
+    add("clear", bestNsPerOp(cc.size(), rounds, [&] { work = cc; }, [&] {
+        work.clear();
+    }));
+    add("erase", bestNsPerOp(n, rounds, [&] { work = cc; }, [&] {
+        for (long k: w.lookups) {
+            work.erase(k);
+        }
+    }));
+}
+
+int main(int argc, char **argv) {
+    std::size_t const max_size = benchOption(argc, argv, "--max-size", 1000000);
+    BenchReport report(argc, argv, {"container", "op", "dist", "size", "ns_per_op"});
+    std::mt19937_64 rng(42);
+    for (std::size_t n = 1000; n <= max_size; n *= 10) {
+        int const rounds = n >= 1000000 ? 1 : 3;
+        for (char const *dist: {"sequential", "random", "zipf"}) {
+            Workload w = makeWorkload(dist, n, rng);
+            runContainer<Map<long, long> >(report, "Map", w, rounds);
+            runContainer<std::map<long, long> >(report, "std::map", w, rounds);
+            runContainer<Set<long> >(report, "Set", w, rounds);
+            runContainer<std::set<long> >(report, "std::set", w, rounds);
+            runContainer<MultiSet<long> >(report, "MultiSet", w, rounds);
+            runContainer<std::multiset<long> >(report, "std::multiset", w, rounds);
+        }
+    }
+    return 0;
+}
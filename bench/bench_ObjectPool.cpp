@@ -0,0 +1,61 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// ObjectPool 与 makeUnique/makeShared 的创建+销毁耗时对比
+// 每个线程保持一个滑动窗口的存活对象，模拟请求/响应结构体的生命周期
+// 输出 mode,threads,ns_per_op；默认 CSV，--json 输出 JSON；ns_per_op 是每个线程上一次创建+销毁的墙钟时间
+// threads 从 1 到 --max-threads (默认取核数与 8 的较大者)
+#include "BenchHarness.hpp"
+#include <ObjectPool.hpp>
+#include <SmartPtr.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+constexpr int kOpsPerThread = 2000000;
+constexpr std::size_t kWindow = 64;
+constexpr int kRounds = 3;
+
+struct Request {
+    long id;
+    char payload[112];
+    explicit Request(long i) : id(i), payload{} {}
+};
+
+template<class Body>
+double run(unsigned threads, Body body) {
+    return bestNsPerOpThreads(kOpsPerThread, kRounds, threads, [&](unsigned) { body(); });
+}
+
+// 环形窗口：新对象覆盖最老的对象，覆盖时旧对象被销毁
+template<class Make>
+void churn(Make make) {
+    using Handle = decltype(make(0));
+    std::vector<Handle> window(kWindow);
+    for(int i = 0; i < kOpsPerThread; ++i) {
+        window[i % kWindow] = make(i);
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned const hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned const max_threads = unsigned(benchOption(argc, argv, "--max-threads", std::max(hw, 8u)));
+    BenchReport report(argc, argv, {"mode", "threads", "ns_per_op"});
+    for(unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        report.add("makeUnique", threads, run(threads, [] {
+            churn([](long i) { return makeUnique<Request>(i); });
+        }));
+        ObjectPool<Request> pool;
+        report.add("pool_unique", threads, run(threads, [&] {
+            churn([&](long i) { return pool.make(i); });
+        }));
+        report.add("makeShared", threads, run(threads, [] {
+            churn([](long i) { return makeShared<Request>(i); });
+        }));
+        report.add("pool_shared", threads, run(threads, [&] {
+            churn([&](long i) { return pool.makeShared(i); });
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// SmartPtr.hpp / Variant.hpp 的基本操作与标准库对应物的耗时对比
+// 输出 group,case,param,ns_per_op；默认 CSV，--json 输出 JSON，方便不同版本之间 diff
+// alloc: 创建并销毁一个对象，param 为 1
+// contention: 所有线程共用一个控制块，param 是线程数 (1 到 --max-threads，默认 64)，ns_per_op 是每个线程上一次操作的墙钟时间
+//   copy_destroy 复制后立刻销毁 (一次加一次减)，move 在两个句柄之间来回移动 (不碰计数)
+// shared_from_this: 从对象本身取回 SharedPtr 再销毁
+// unique: UniquePtr 与裸指针的创建/销毁和解引用
+// visit: Variant::visit 与 std::visit，param 是候选项个数 (2 / 8 / 32)
+#include "BenchHarness.hpp"
+#include <SmartPtr.hpp>
+#include <Variant.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <utility>
+#include <variant>
+#include <vector>
+
+constexpr std::size_t kOps = 1000000;
+constexpr int kRounds = 3;
+
+struct Payload {
+    long value = 1;
+};
+
+struct SelfPayload : EnableSharedFromThis<SelfPayload> {
+    long value = 1;
+};
+
+struct StdSelfPayload : std::enable_shared_from_this<StdSelfPayload> {
+    long value = 1;
+};
+
+template<std::size_t I>
+struct Alt {
+    long value = I;
+};
+
+// 每个线程做 kOps 次 body，返回每个线程上一次操作的耗时
+template<class Body>
+double contended(unsigned threads, Body body) {
+    return bestNsPerOpThreads(kOps, kRounds, threads, [&](unsigned) { body(); });
+}
+
+void benchAlloc(BenchReport &report) {
+    report.add("alloc", "makeShared", 1, bestNsPerOp(kOps, kRounds, [] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            SharedPtr<Payload> p = makeShared<Payload>();
+            benchKeep(p->value);
+        }
+    }));
+    report.add("alloc", "SharedPtr(new)", 1, bestNsPerOp(kOps, kRounds, [] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            SharedPtr<Payload> p(new Payload);
+            benchKeep(p->value);
+        }
+    }));
+    report.add("alloc", "std::make_shared", 1, bestNsPerOp(kOps, kRounds, [] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            std::shared_ptr<Payload> p = std::make_shared<Payload>();
+            benchKeep(p->value);
+        }
+    }));
+    report.add("alloc", "std::shared_ptr(new)", 1, bestNsPerOp(kOps, kRounds, [] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            std::shared_ptr<Payload> p(new Payload);
+            benchKeep(p->value);
+        }
+    }));
+}
+
+template<class Ptr>
+void benchContention(BenchReport &report, char const *name, Ptr const &shared, unsigned max_threads) {
+    std::string const copy_case = std::string(name) + "_copy_destroy";
+    std::string const move_case = std::string(name) + "_move";
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        report.add("contention", copy_case, threads, contended(threads, [&] {
+            for (std::size_t i = 0; i < kOps; ++i) {
+                Ptr copy = shared;
+                benchKeep(copy);
+            }
+        }));
+        report.add("contention", move_case, threads, contended(threads, [&] {
+            Ptr a = shared;
+            Ptr b;
+            for (std::size_t i = 0; i < kOps; i += 2) {
+                b = std::move(a);
+                benchKeep(b);
+                a = std::move(b);
+                benchKeep(a);
+            }
+        }));
+    }
+}
+
+void benchSharedFromThis(BenchReport &report) {
+    SharedPtr<SelfPayload> self = makeShared<SelfPayload>();
+    report.add("shared_from_this", "SharedPtr", 1, bestNsPerOp(kOps, kRounds, [&] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            SharedPtr<SelfPayload> p = self->shared_from_this();
+            benchKeep(p);
+        }
+    }));
+    std::shared_ptr<StdSelfPayload> std_self = std::make_shared<StdSelfPayload>();
+    report.add("shared_from_this", "std::shared_ptr", 1, bestNsPerOp(kOps, kRounds, [&] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            std::shared_ptr<StdSelfPayload> p = std_self->shared_from_this();
+            benchKeep(p);
+        }
+    }));
+}
+
+void benchUnique(BenchReport &report) {
+    report.add("unique", "UniquePtr_create", 1, bestNsPerOp(kOps, kRounds, [] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            UniquePtr<Payload> p(new Payload);
+            benchKeep(p->value);
+        }
+    }));
+    report.add("unique", "raw_create", 1, bestNsPerOp(kOps, kRounds, [] {
+        for (std::size_t i = 0; i < kOps; ++i) {
+            Payload *p = new Payload;
+            benchKeep(p->value);
+            delete p;
+        }
+    }));
+    constexpr std::size_t kObjects = 1 << 12;
+    std::vector<UniquePtr<Payload> > owned;
+    std::vector<Payload *> raw;
+    for (std::size_t i = 0; i < kObjects; ++i) {
+        owned.emplace_back(new Payload);
+        raw.push_back(owned.back().get());
+    }
+    report.add("unique", "UniquePtr_deref", 1, bestNsPerOp(kOps, kRounds, [&] {
+        long sum = 0;
+        for (std::size_t i = 0; i < kOps; ++i) {
+            sum += owned[i % kObjects]->value;
+        }
+        benchKeep(sum);
+    }));
+    report.add("unique", "raw_deref", 1, bestNsPerOp(kOps, kRounds, [&] {
+        long sum = 0;
+        for (std::size_t i = 0; i < kOps; ++i) {
+            sum += raw[i % kObjects]->value;
+        }
+        benchKeep(sum);
+    }));
+}
+
+template<std::size_t... Is>
+void benchVisit(BenchReport &report, std::index_sequence<Is...>) {
+    constexpr std::size_t N = sizeof...(Is);
+    using Ours = Variant<Alt<Is>...>;
+    using Std = std::variant<Alt<Is>...>;
+    constexpr std::size_t kElements = 1 << 12;
+    std::mt19937 rng(42);
+    std::vector<Ours> ours;
+    std::vector<Std> theirs;
+    for (std::size_t i = 0; i < kElements; ++i) {
+        std::size_t const index = rng() % N;
+        ours.push_back(variant_dispatch<Ours, N>(index, [](auto I) {
+            return Ours(inPlaceIndex<decltype(I)::value>);
+        }));
+        theirs.push_back(variant_dispatch<Std, N>(index, [](auto I) {
+            return Std(std::in_place_index<decltype(I)::value>);
+        }));
+    }
+    auto value = [](auto const &alt) { return alt.value; };
+    report.add("visit", "Variant::visit", N, bestNsPerOp(kOps, kRounds, [&] {
+        long sum = 0;
+        for (std::size_t i = 0; i < kOps; ++i) {
+            sum += ours[i % kElements].visit(value);
+        }
+        benchKeep(sum);
+    }));
+    report.add("visit", "std::visit", N, bestNsPerOp(kOps, kRounds, [&] {
+        long sum = 0;
+        for (std::size_t i = 0; i < kOps; ++i) {
+            sum += std::visit(value, theirs[i % kElements]);
+        }
+        benchKeep(sum);
+    }));
+}
+
+int main(int argc, char **argv) {
+    unsigned const max_threads = unsigned(benchOption(argc, argv, "--max-threads", 64));
+    BenchReport report(argc, argv, {"group", "case", "param", "ns_per_op"});
+    benchAlloc(report);
+    benchContention(report, "SharedPtr", makeShared<Payload>(), max_threads);
+    benchContention(report, "std::shared_ptr", std::make_shared<Payload>(), max_threads);
+    benchSharedFromThis(report);
+    benchUnique(report);
+    benchVisit(report, std::make_index_sequence<2>{});
+    benchVisit(report, std::make_index_sequence<8>{});
+    benchVisit(report, std::make_index_sequence<32>{});
+    return 0;
+}
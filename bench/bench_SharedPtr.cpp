@@ -0,0 +1,115 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// SharedPtr 复制/销毁的耗时
+// 输出 mode,threads,ns_per_op；默认 CSV，--json 输出 JSON；ns_per_op 是每个线程上一次操作的墙钟时间
+// 多线程的模式 threads 从 1 到 --max-threads (默认取核数与 8 的较大者)
+// shared: 所有线程复制同一个 SharedPtr，计数所在的缓存行在线程间来回
+// private: 每个线程各自复制自己的 SharedPtr，只有原子指令本身的开销
+// unique: 反复创建并销毁唯一持有的对象，覆盖 deref 的快速路径
+// pooled: 同 unique，但用 allocateShared + ThreadLocalPoolAllocator 分配
+// local: 单线程下 SpNonAtomicPolicy 与 SpAtomicPolicy 的复制开销对比
+// intrusive: 单线程下 IntrusivePtr 的复制开销，计数在对象里，句柄只有 8 字节
+// teardown: 销毁装满 SharedPtr<HeavyPayload> 的 vector 时请求线程上每个对象的耗时，deferred 把析构交给 SpBackgroundReclaimer
+#include "BenchHarness.hpp"
+#include <DeferredRelease.hpp>
+#include <IntrusivePtr.hpp>
+#include <PoolAllocator.hpp>
+#include <SmartPtr.hpp>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+constexpr int kOpsPerThread = 2000000;
+constexpr int kTeardownObjects = kOpsPerThread / 4;
+constexpr int kRounds = 3;
+
+struct Payload {
+    long value = 1;
+};
+
+// 析构要释放自己的缓冲区，代表一般的业务对象
+struct HeavyPayload {
+    std::vector<long> data = std::vector<long>(32, 1);
+};
+
+struct IntrusivePayload : IntrusiveRefCounted<IntrusivePayload> {
+    long value = 1;
+};
+
+template<class Body>
+double run(unsigned threads, Body body) {
+    return bestNsPerOpThreads(kOpsPerThread, kRounds, threads, [&](unsigned) { body(); });
+}
+
+int main(int argc, char **argv) {
+    unsigned const hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned const max_threads = unsigned(benchOption(argc, argv, "--max-threads", std::max(hw, 8u)));
+    BenchReport report(argc, argv, {"mode", "threads", "ns_per_op"});
+    for(unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        auto shared = makeShared<Payload>();
+        report.add("shared", threads, run(threads, [&] {
+            for(int i = 0; i < kOpsPerThread; ++i) {
+                SharedPtr<Payload> copy = shared;
+                benchKeep(copy->value);
+            }
+        }));
+        report.add("private", threads, run(threads, [&] {
+            auto mine = makeShared<Payload>();
+            for(int i = 0; i < kOpsPerThread; ++i) {
+                SharedPtr<Payload> copy = mine;
+                benchKeep(copy->value);
+            }
+        }));
+        report.add("unique", threads, run(threads, [&] {
+            for(int i = 0; i < kOpsPerThread; ++i) {
+                SharedPtr<Payload> one = makeShared<Payload>();
+                benchKeep(one->value);
+            }
+        }));
+        report.add("pooled", threads, run(threads, [&] {
+            for(int i = 0; i < kOpsPerThread; ++i) {
+                SharedPtr<Payload> one = allocateShared<Payload>(ThreadLocalPoolAllocator<Payload>());
+                benchKeep(one->value);
+            }
+        }));
+    }
+    auto atomic_one = makeShared<Payload>();
+    report.add("atomic_copy", 1u, run(1, [&] {
+        for(int i = 0; i < kOpsPerThread; ++i) {
+            SharedPtr<Payload> copy = atomic_one;
+            benchKeep(copy->value);
+        }
+    }));
+    auto local_one = makeShared<Payload,SpNonAtomicPolicy>();
+    report.add("local_copy", 1u, run(1, [&] {
+        for(int i = 0; i < kOpsPerThread; ++i) {
+            LocalSharedPtr<Payload> copy = local_one;
+            benchKeep(copy->value);
+        }
+    }));
+    auto intrusive_one = makeIntrusive<IntrusivePayload>();
+    report.add("intrusive_copy", 1u, run(1, [&] {
+        for(int i = 0; i < kOpsPerThread; ++i) {
+            IntrusivePtr<IntrusivePayload> copy = intrusive_one;
+            benchKeep(copy->value);
+        }
+    }));
+
+    std::vector<SharedPtr<HeavyPayload> > objs;
+    SpBackgroundReclaimer reclaimer;
+    auto fill = [&] {
+        reclaimer.flush();  // 上一轮交出去的对象不能和这一轮的计时重叠
+        for(int i = 0; i < kTeardownObjects; ++i) {
+            objs.push_back(makeShared<HeavyPayload>());
+        }
+    };
+    report.add("teardown_inline", 1u, bestNsPerOp(kTeardownObjects, kRounds, fill, [&] {
+        objs.clear();
+    }));
+    report.add("teardown_deferred", 1u, bestNsPerOp(kTeardownObjects, kRounds, fill, [&] {
+        SpDeferredReleaseScope scope(reclaimer);
+        objs.clear();
+    }));
+    return 0;
+}
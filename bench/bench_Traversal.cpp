@@ -0,0 +1,53 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// 迭代器循环、线索化迭代器与 for_each_inorder 的全量遍历耗时对比
+// 输出 size,mode,ns_per_op (每个元素)；默认 CSV，--json 输出 JSON
+#include "BenchHarness.hpp"
+#include <Set.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+constexpr int kRounds = 5;
+
+int main(int argc, char **argv) {
+    BenchReport report(argc, argv, {"size", "mode", "ns_per_op"});
+    for (std::size_t n: {std::size_t(1) << 10, std::size_t(1) << 14, std::size_t(1) << 18, std::size_t(1) << 20}) {
+        // 随机插入顺序让节点在内存中分散，接近真实使用场景
+        std::vector<long> keys(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            keys[i] = long(i);
+        }
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+        Set<long> s;
+        ThreadedSet<long> ts;
+        for (long k: keys) {
+            s.insert(k);
+            ts.insert(k);
+        }
+        report.add(n, "iterator", bestNsPerOp(n, kRounds, [&] {
+            long sum = 0;
+            for (long x: s) {
+                sum += x;
+            }
+            benchKeep(sum);
+        }));
+        report.add(n, "threaded_iterator", bestNsPerOp(n, kRounds, [&] {
+            long sum = 0;
+            for (long x: ts) {
+                sum += x;
+            }
+            benchKeep(sum);
+        }));
+        report.add(n, "for_each_inorder", bestNsPerOp(n, kRounds, [&] {
+            long sum = 0;
+            s.for_each_inorder([&sum](long x) {
+                sum += x;
+            });
+            benchKeep(sum);
+        }));
+    }
+    return 0;
+}
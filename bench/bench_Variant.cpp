@@ -0,0 +1,102 @@
+//
+// Created by wxk on 2026/10/18.
+//
+// Variant::visit 的分派开销
+// 输出 mode,elements,ns_per_op (每次访问)；默认 CSV，--json 输出 JSON
+// switch: 当前的 visit (编译期展开的 switch，访问者可以被内联)
+// table: 旧的实现，函数内 static 的函数指针表，每次访问一次间接调用
+// binary_flat / binary_nested: 两个 Variant 的二元运算，一次扁平分派对比两层嵌套的 visit
+// soa_visit_all: 同样的数据放进 VariantVector，逐列求和，没有逐元素的分派
+#include "BenchHarness.hpp"
+#include <Variant.hpp>
+#include <VariantVector.hpp>
+#include <cstddef>
+#include <functional>
+#include <random>
+#include <vector>
+
+using Message = Variant<int, double, long, float>;
+
+template<class Lambda, class... Ts>
+auto table_visit(Variant<Ts...> &v, Lambda &&lambda) {
+    using R = std::common_type_t<std::invoke_result_t<Lambda, Ts &>...>;
+    using Function = R (*)(Variant<Ts...> &, Lambda &&);
+    static Function function_ptrs[sizeof...(Ts)] = {
+        [](Variant<Ts...> &v, Lambda &&lambda) -> R {
+            return std::invoke(std::forward<Lambda>(lambda), v.template get<Ts>());
+        }...
+    };
+    return function_ptrs[v.index()](v, std::forward<Lambda>(lambda));
+}
+
+int main(int argc, char **argv) {
+    constexpr std::size_t kElements = 1 << 16;
+    constexpr int kPasses = 200;    // 每次计时把整个数组访问 kPasses 遍
+    constexpr int kRounds = 3;
+    constexpr std::size_t kVisits = kElements * kPasses;
+    std::mt19937 rng(42);
+    std::vector<Message> messages;
+    messages.reserve(kElements);
+    for(std::size_t i = 0; i < kElements; ++i) {
+        switch(rng() % 4) {
+            case 0: messages.emplace_back(int(i)); break;
+            case 1: messages.emplace_back(double(i)); break;
+            case 2: messages.emplace_back(long(i)); break;
+            default: messages.emplace_back(float(i)); break;
+        }
+    }
+    auto to_double = [](auto &arg) { return double(arg); };
+    BenchReport report(argc, argv, {"mode", "elements", "ns_per_op"});
+    report.add("switch", kElements, bestNsPerOp(kVisits, kRounds, [&] {
+        double sum = 0;
+        for(int r = 0; r < kPasses; ++r) {
+            for(Message &m: messages) {
+                sum += m.visit(to_double);
+            }
+        }
+        benchKeep(sum);
+    }));
+    report.add("table", kElements, bestNsPerOp(kVisits, kRounds, [&] {
+        double sum = 0;
+        for(int r = 0; r < kPasses; ++r) {
+            for(Message &m: messages) {
+                sum += table_visit(m, to_double);
+            }
+        }
+        benchKeep(sum);
+    }));
+    auto add = [](auto a, auto b) { return double(a) + double(b); };
+    report.add("binary_flat", kElements, bestNsPerOp(kVisits, kRounds, [&] {
+        double sum = 0;
+        for(int r = 0; r < kPasses; ++r) {
+            for(std::size_t i = 0; i + 1 < kElements; ++i) {
+                sum += Visit(add, messages[i], messages[i + 1]);
+            }
+        }
+        benchKeep(sum);
+    }));
+    report.add("binary_nested", kElements, bestNsPerOp(kVisits, kRounds, [&] {
+        double sum = 0;
+        for(int r = 0; r < kPasses; ++r) {
+            for(std::size_t i = 0; i + 1 < kElements; ++i) {
+                sum += table_visit(messages[i], [&](auto &a) {
+                    return table_visit(messages[i + 1], [&](auto &b) { return add(a, b); });
+                });
+            }
+        }
+        benchKeep(sum);
+    }));
+    VariantVector<int, double, long, float> columns;
+    columns.reserve(kElements);
+    for(Message &m: messages) {
+        columns.push_back(m);
+    }
+    report.add("soa_visit_all", kElements, bestNsPerOp(kVisits, kRounds, [&] {
+        double sum = 0;
+        for(int r = 0; r < kPasses; ++r) {
+            columns.visit_all([&](auto &arg) { sum += double(arg); });
+        }
+        benchKeep(sum);
+    }));
+    return 0;
+}
@@ -0,0 +1,149 @@
+//
+// Created by wxk on 2026/10/18.
+//
+#include <ConcurrentSkipList.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+TEST_CASE("insert and find","[ConcurrentSet]") {
+    ConcurrentSet<int> s;
+    REQUIRE(s.insert(3).second == true);
+    REQUIRE(s.insert(1).second == true);
+    REQUIRE(s.insert(2).second == true);
+    REQUIRE(s.insert(1).second == false);  //插入重复的键返回 false
+    REQUIRE(s.size() == 3);
+    REQUIRE(s.find(2) != s.end());
+    REQUIRE(*s.find(2) == 2);
+    REQUIRE(s.find(4) == s.end());
+    REQUIRE(s.contains(3));
+    REQUIRE(s.count(5) == 0);
+}
+
+TEST_CASE("ordered iteration","[ConcurrentSet]") {
+    ConcurrentSet<int> s;
+    for (int i: {5, 3, 9, 1, 7}) {
+        s.insert(i);
+    }
+    std::vector<int> v(s.begin(), s.end());
+    REQUIRE(v == std::vector<int>{1, 3, 5, 7, 9});
+
+    // 只有指向节点的迭代器占着 epoch，end() 和走到末尾的迭代器不占
+    _EpochRecord *rec = _EpochThreadHandle::_S_local();
+    auto end = s.end();
+    REQUIRE(rec->_M_nesting == 0);
+    auto it = s.begin();
+    auto copy = it;
+    REQUIRE(rec->_M_nesting == 2);
+    copy = end;
+    REQUIRE(rec->_M_nesting == 1);
+    while (it != end) {
+        ++it;
+    }
+    REQUIRE(rec->_M_nesting == 0);
+}
+
+TEST_CASE("lower_bound upper_bound","[ConcurrentSet]") {
+    ConcurrentSet<int> s;
+    for (int i = 0; i < 10; i += 2) {
+        s.insert(i);
+    }
+    REQUIRE(*s.lower_bound(4) == 4);
+    REQUIRE(*s.lower_bound(5) == 6);
+    REQUIRE(*s.upper_bound(4) == 6);
+    REQUIRE(s.upper_bound(8) == s.end());
+}
+
+TEST_CASE("erase","[ConcurrentSet]") {
+    ConcurrentSet<int> s;
+    s.insert(1);
+    s.insert(2);
+    s.insert(3);
+    REQUIRE(s.erase(2) == 1);
+    REQUIRE(s.erase(2) == 0);
+    REQUIRE(!s.contains(2));
+    REQUIRE(s.size() == 2);
+    REQUIRE(s.insert(2).second == true);
+    REQUIRE(s.contains(2));
+}
+
+TEST_CASE("concurrent insert and erase","[ConcurrentSet]") {
+    ConcurrentSet<int> s;
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&s, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                s.insert(i * kThreads + t);
+            }
+            // 删除自己插入的奇数
+            for (int i = 1; i < kPerThread; i += 2) {
+                s.erase(i * kThreads + t);
+            }
+        });
+    }
+    for (auto &th: threads) {
+        th.join();
+    }
+    REQUIRE(s.size() == kThreads * kPerThread / 2);
+    int prev = -1;
+    std::size_t n = 0;
+    for (int x: s) {
+        REQUIRE(prev < x);
+        REQUIRE((x / kThreads) % 2 == 0);
+        prev = x;
+        ++n;
+    }
+    REQUIRE(n == s.size());
+}
+
+TEST_CASE("contended same keys","[ConcurrentSet]") {
+    ConcurrentSet<int> s;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&s] {
+            for (int round = 0; round < 2000; ++round) {
+                s.insert(round % 64);
+                s.erase((round + 32) % 64);
+            }
+        });
+    }
+    for (auto &th: threads) {
+        th.join();
+    }
+    int prev = -1;
+    for (int x: s) {
+        REQUIRE(prev < x);
+        prev = x;
+    }
+}
+
+TEST_CASE("map insert and find","[ConcurrentOrderedMap]") {
+    ConcurrentOrderedMap<int, std::string> m;
+    REQUIRE(m.insert({2, "two"}).second == true);
+    REQUIRE(m.emplace(1, "one").second == true);
+    REQUIRE(m.try_emplace(1, "uno").second == false);
+    REQUIRE(m.find(1)->second == "one");
+    REQUIRE(m.lower_bound(2)->first == 2);
+    REQUIRE(m.upper_bound(1)->first == 2);
+    REQUIRE(m.erase(1) == 1);
+    REQUIRE(!m.contains(1));
+    REQUIRE(m.begin()->second == "two");
+}
+
+TEST_CASE("const map heterogeneous lookup","[ConcurrentOrderedMap]") {
+    ConcurrentOrderedMap<std::string, int, std::less<> > m;
+    for (std::string key: {"apple", "banana", "cherry"}) {
+        m.insert({key, int(key.size())});
+    }
+    auto const &cm = m;
+    std::string_view key = "b";
+    REQUIRE(cm.lower_bound(key)->first == "banana");
+    REQUIRE(cm.upper_bound(std::string_view("banana"))->first == "cherry");
+    REQUIRE(cm.lower_bound(std::string_view("d")) == cm.end());
+    REQUIRE(cm.find(std::string_view("cherry"))->second == 6);
+    REQUIRE(cm.contains(std::string_view("apple")));
+}
@@ -7,6 +7,9 @@
 #include <iostream>
 #include <RbTree.hpp>
 #include <Set.hpp>
+#include <ParallelTree.hpp>
+#include <string>
+#include <vector>
 
 using namespace std;
 TEST_CASE("insert and find","[set]") {
@@ -182,3 +185,211 @@ TEST_CASE("extract","[set]") {
     REQUIRE(it.value()==2);
     REQUIRE(s.count(2)==0);
 }
+
+TEST_CASE("random insert and erase","[set]") {
+    Set<int> s;
+    std::set<int> ref;
+    std::srand(42);
+    for (int i = 0; i < 20000; ++i) {
+        int k = std::rand() % 512;
+        if (std::rand() % 2) {
+            REQUIRE(s.insert(k).second == ref.insert(k).second);
+        } else {
+            REQUIRE(s.erase(k) == ref.erase(k));
+        }
+    }
+    REQUIRE(std::equal(s.begin(), s.end(), ref.begin(), ref.end()));
+    while (!ref.empty()) {
+        REQUIRE(*s.begin() == *ref.begin());
+        s.erase(s.begin());
+        ref.erase(ref.begin());
+    }
+    REQUIRE(s.empty());
+}
+
+TEST_CASE("parallel_for_each and parallel_reduce","[parallel]") {
+    Map<int, long> m;
+    for (int i = 0; i < 5000; ++i) {
+        m.insert({i, i});
+    }
+    parallel_for_each(m, [](std::pair<int const, long> &kv) {
+        kv.second *= 2;
+    }, 4);
+    REQUIRE(m.at(10) == 20);
+    long sum = parallel_transform_reduce(m, 0L, std::plus<>(), [](auto const &kv) {
+        return kv.second;
+    }, 4);
+    REQUIRE(sum == 2L * 4999 * 5000 / 2);
+    // Map 上的 parallel_reduce 归约的是 value
+    REQUIRE(parallel_reduce(m, 0L, std::plus<>(), 4) == 2L * 4999 * 5000 / 2);
+    REQUIRE(parallel_reduce(m, 1L, [](long a, long b) { return std::max(a, b); }) == 2L * 4999);
+    REQUIRE(parallel_reduce(Map<int, long>(), 5L) == 5L);
+
+    Set<int> s;
+    for (int i = 0; i < 3000; ++i) {
+        s.insert(i);
+    }
+    REQUIRE(parallel_reduce(s, 0L, std::plus<>(), 3) == 2999L * 3000 / 2);
+    // 非交换的归约需要保持 key 的顺序
+    std::string digits = parallel_transform_reduce(s, std::string(), std::plus<>(), [](int x) {
+        return std::string(1, char('0' + x % 10));
+    }, 8);
+    std::string expected;
+    for (int i = 0; i < 3000; ++i) {
+        expected += char('0' + i % 10);
+    }
+    REQUIRE(digits == expected);
+    REQUIRE(parallel_reduce(Set<int>(), 7) == 7);
+}
+
+TEST_CASE("for_each_inorder","[set]") {
+    Set<int> s;
+    std::set<int> ref;
+    std::srand(7);
+    for (int i = 0; i < 4000; ++i) {
+        int x = std::rand() % 10000;
+        s.insert(x);
+        ref.insert(x);
+    }
+    std::vector<int> v;
+    s.for_each_inorder([&v](int x) {
+        v.push_back(x);
+    });
+    REQUIRE(std::equal(v.begin(), v.end(), ref.begin(), ref.end()));
+
+    Map<int, int> m;
+    for (int i = 0; i < 100; ++i) {
+        m.insert({i, 0});
+    }
+    m.for_each_inorder([](std::pair<int const, int> &kv) {
+        kv.second = kv.first * 3;
+    });
+    REQUIRE(m.at(7) == 21);
+    Map<int, int> const &cm = m;
+    long sum = 0;
+    cm.for_each_inorder([&sum](auto const &kv) {
+        sum += kv.second;
+    });
+    REQUIRE(sum == 3L * 99 * 100 / 2);
+    Set<int>().for_each_inorder([](int) {
+        FAIL("empty tree");
+    });
+}
+
+TEST_CASE("threaded set iteration","[ThreadedSet]") {
+    ThreadedMultiSet<int> s;
+    std::multiset<int> ref;
+    std::srand(11);
+    for (int i = 0; i < 20000; ++i) {
+        int k = std::rand() % 256;
+        if (std::rand() % 3) {
+            s.insert(k);
+            ref.insert(k);
+        } else {
+            auto it = s.find(k);
+            auto rit = ref.find(k);
+            REQUIRE((it == s.end()) == (rit == ref.end()));
+            if (it != s.end()) {
+                s.erase(it);
+                ref.erase(rit);
+            }
+        }
+    }
+    REQUIRE(std::equal(s.begin(), s.end(), ref.begin(), ref.end()));
+    REQUIRE(std::equal(s.rbegin(), s.rend(), ref.rbegin(), ref.rend()));
+    // 从 end() 往回走
+    auto it = s.end();
+    auto rit = ref.end();
+    while (rit != ref.begin()) {
+        --it;
+        --rit;
+        REQUIRE(*it == *rit);
+    }
+    REQUIRE(it == s.begin());
+
+    ThreadedSet<int> t;
+    for (int i = 0; i < 100; ++i) {
+        t.insert(i);
+    }
+    auto nh = t.extract(50);
+    REQUIRE(nh.value() == 50);
+    REQUIRE(*++t.find(49) == 51);
+    REQUIRE(*--t.find(51) == 49);
+    std::vector<int> range(t.lower_bound(47), t.upper_bound(52));
+    REQUIRE(range == std::vector<int>{47, 48, 49, 51, 52});
+    REQUIRE(t.erase(99) == 1);
+    REQUIRE(*--t.end() == 98);
+    auto last = t.erase(t.begin(), t.end());
+    REQUIRE(last == t.end());
+    REQUIRE(t.empty());
+}
+
+TEST_CASE("threaded map","[ThreadedMap]") {
+    ThreadedMap<int, std::string> m;
+    m.insert({2, "two"});
+    m.insert({1, "one"});
+    m.insert({3, "three"});
+    m.erase(2);
+    std::string joined;
+    for (auto &kv: m) {
+        joined += kv.second;
+    }
+    REQUIRE(joined == "onethree");
+    REQUIRE(m.at(3) == "three");
+}
+
+TEST_CASE("copy assignment","[MultiSet]") {
+    MultiSet<int> ms;
+    for (int x: {3, 1, 3, 2}) {
+        ms.insert(x);
+    }
+    MultiSet<int> ms_copy(ms);
+    MultiSet<int> ms_assigned;
+    ms_assigned = ms;
+    REQUIRE(std::vector<int>(ms_copy.begin(), ms_copy.end()) == std::vector<int>{1, 2, 3, 3});
+    REQUIRE(std::vector<int>(ms_assigned.begin(), ms_assigned.end()) == std::vector<int>{1, 2, 3, 3});
+
+    Map<int, int> m;
+    m.insert({1, 10});
+    m.insert({2, 20});
+    Map<int, int> m_assigned;
+    m_assigned.insert({5, 50});
+    m_assigned = m;
+    REQUIRE(m_assigned.size() == 2);
+    REQUIRE(m_assigned.at(2) == 20);
+    REQUIRE(!m_assigned.contains(5));
+}
+
+TEST_CASE("tree stats","[InstrumentedSet]") {
+    static_assert(sizeof(Set<int>) == sizeof(void *)); // 关闭统计时不占空间
+    InstrumentedSet<int> s;
+    for (int i = 0; i < 100; ++i) {
+        s.insert(i);        // 顺序插入，每次都要旋转
+    }
+    auto const &st = s.stats();
+    REQUIRE(st.allocations == 100);
+    REQUIRE(st.rotate_left > 0);
+    REQUIRE(st.rotate_right == 0);
+    REQUIRE(st.fix_violation_steps >= 100);
+    REQUIRE(st.max_depth > 1);
+    REQUIRE(st.max_depth <= 14);    // 2 * log2(101)
+    REQUIRE(!s.insert(50).second);
+    REQUIRE(st.allocations == 101);
+    REQUIRE(st.deallocations == 1); // 重复的键分配后立即释放
+
+    s.reset_stats();
+    REQUIRE(st.comparisons == 0);
+    REQUIRE(s.contains(42));
+    REQUIRE(st.comparisons > 0);
+    REQUIRE(st.comparisons <= 28);  // 每层最多两次比较
+
+    s.clear();
+    REQUIRE(st.deallocations == 100);
+    REQUIRE(st.delete_fixup_steps > 0);
+
+    InstrumentedMap<int, int> m;
+    m.insert({1, 1});
+    m.insert({2, 2});
+    REQUIRE(m.stats().allocations == 2);
+    REQUIRE(m.stats().comparisons > 0);
+}
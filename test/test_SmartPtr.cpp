@@ -2,7 +2,13 @@
 // Created by wxk on 2024/10/14.
 //
 #include "SmartPtr.hpp"
+#include "AtomicSharedPtr.hpp"
+#include "DeferredRelease.hpp"
+#include "IntrusivePtr.hpp"
+#include "ObjectPool.hpp"
+#include "PoolAllocator.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <thread>
 
 struct MyClass {
     int a,b,c;
@@ -69,6 +75,35 @@ TEST_CASE("polymorphic","[UniquePtr]") {
     }
 }
 
+TEST_CASE("stateful deleter","[UniquePtr]") {
+    static_assert(sizeof(UniquePtr<int>) == sizeof(int *));
+    static_assert(sizeof(UniquePtr<FILE,FileDeleter>) == sizeof(FILE *));
+    struct CountingDeleter {
+        int *deleted;
+        void operator()(int *p) const {
+            ++*deleted;
+            delete p;
+        }
+    };
+    int deleted = 0;
+    {
+        UniquePtr<int,CountingDeleter> a(new int(1),CountingDeleter{&deleted});
+        UniquePtr<int,CountingDeleter> b(new int(2),CountingDeleter{&deleted});
+        REQUIRE(&a.get_deleter() != &b.get_deleter());
+        b = std::move(a);   // b 原来的对象要先释放
+        REQUIRE(deleted == 1);
+        REQUIRE(*b == 1);
+        REQUIRE(!a);
+        b.reset(new int(3));
+        REQUIRE(deleted == 2);
+    }
+    REQUIRE(deleted == 3);
+
+    UniquePtr<int> empty;
+    empty = makeUnique<int>(4);  // 原来是空的也要接管
+    REQUIRE(*empty == 4);
+}
+
 TEST_CASE("makeShared and enable_shared_from_this","[SharePtr]") {
     SharedPtr<Student> sp1 = makeShared<Student>("wxk",23);
     SharedPtr<Student> sp2(new Student("wxk",23));
@@ -99,6 +134,483 @@ TEST_CASE("explicit translation","[SharedPtr]") {
     REQUIRE(sp3->age_ == 23);
 }
 
+struct Tracked {
+    static inline int alive = 0;
+    int value;
+    explicit Tracked(int v = 0):value(v) { ++alive; }
+    ~Tracked() { --alive; }
+};
+
+TEST_CASE("pool deleter","[UniquePtr]") {
+    FreeListPool<Tracked> pool;
+    void *first;
+    {
+        auto a = pool.make(1);
+        first = a.get();
+        REQUIRE(Tracked::alive == 1);
+        REQUIRE(a.get_deleter().pool == &pool);
+    }
+    REQUIRE(Tracked::alive == 0);
+    auto b = pool.make(2);
+    REQUIRE(static_cast<void *>(b.get()) == first); // 刚还回去的块马上被复用
+
+    // 转成 SharedPtr 之后删除器跟着进入控制块，最后一个 SharedPtr 负责还给池子
+    SharedPtr<Tracked> shared(std::move(b));
+    REQUIRE(b.get() == nullptr);
+    REQUIRE(shared->value == 2);
+    shared.reset();
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(static_cast<void *>(pool.make(3).get()) == first);
+
+    SharedPtr<Tracked> none(FreeListPool<Tracked>::Handle{});
+    REQUIRE(none.get() == nullptr);
+    REQUIRE(none.use_count() == 0);
+}
+
+TEST_CASE("lock and expired","[WeakPtr]") {
+    WeakPtr<Tracked> wp;
+    REQUIRE(wp.expired());
+    REQUIRE(wp.lock().get() == nullptr);
+    {
+        SharedPtr<Tracked> sp(new Tracked(7));
+        wp = sp;
+        REQUIRE(wp.use_count() == 1);
+        SharedPtr<Tracked> locked = wp.lock();
+        REQUIRE(locked->value == 7);
+        REQUIRE(sp.use_count() == 2);
+    }
+    REQUIRE(wp.expired());
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(wp.lock().get() == nullptr);
+    REQUIRE_THROWS_AS(SharedPtr<Tracked>(wp), std::bad_weak_ptr);
+}
+
+TEST_CASE("makeShared object dies before the block","[WeakPtr]") {
+    WeakPtr<Tracked> wp;
+    {
+        auto sp = makeShared<Tracked>(3);
+        wp = sp;
+        WeakPtr<Tracked> wp2 = wp;
+        REQUIRE(Tracked::alive == 1);
+    }
+    // 对象在强引用归零时析构，内存要等 wp 释放
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(wp.expired());
+    wp.reset();
+    REQUIRE(wp.use_count() == 0);
+}
+
+TEST_CASE("weak_from_this","[WeakPtr]") {
+    auto sp = makeShared<Student>("wxk",23);
+    WeakPtr<Student> wp = sp->weak_from_this();
+    REQUIRE(wp.lock().get() == sp.get());
+    sp.reset();
+    REQUIRE(wp.expired());
+}
+
+TEST_CASE("concurrent copy and lock","[SharedPtr]") {
+    // 多个线程同时复制、销毁、lock，对象必须恰好析构一次，且析构时所有写入都可见
+    struct Counted {
+        std::atomic<int> *destroyed;
+        long payload[8]{};
+        ~Counted() {
+            long sum = 0;
+            for(long x: payload) sum += x;
+            CHECK(sum == 0);
+            destroyed->fetch_add(1);
+        }
+    };
+    for(int round = 0; round < 50; ++round) {
+        std::atomic<int> destroyed{0};
+        auto sp = makeShared<Counted>();
+        sp->destroyed = &destroyed;
+        WeakPtr<Counted> wp = sp;
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t) {
+            threads.emplace_back([copy = sp, wp, t]() mutable {
+                for(int i = 0; i < 1000; ++i) {
+                    SharedPtr<Counted> a = copy;
+                    SharedPtr<Counted> b = wp.lock();
+                    if(b.get()) b->payload[t] += 0;
+                }
+                copy.reset();
+            });
+        }
+        sp.reset();
+        for(auto &th: threads) th.join();
+        REQUIRE(destroyed.load() == 1);
+        REQUIRE(wp.expired());
+    }
+}
+
+struct LocalNode:EnableSharedFromThis<LocalNode,SpNonAtomicPolicy> {
+    int id;
+    explicit LocalNode(int i):id(i) {}
+};
+
+TEST_CASE("non-atomic policy","[LocalSharedPtr]") {
+    static_assert(sizeof(SpControlBlock<SpNonAtomicPolicy>) == sizeof(SpControlBlock<SpAtomicPolicy>));
+    LocalSharedPtr<LocalNode> sp = makeShared<LocalNode,SpNonAtomicPolicy>(5);
+    LocalSharedPtr<LocalNode> copy = sp;
+    REQUIRE(sp.use_count() == 2);
+    LocalWeakPtr<LocalNode> wp = sp->weak_from_this();
+    REQUIRE(wp.lock()->id == 5);
+    REQUIRE(sp->shared_from_this().get() == sp.get());
+    copy.reset();
+    sp.reset();
+    REQUIRE(wp.expired());
+    LocalSharedPtr<Tracked> owned(new Tracked(1));
+    REQUIRE(staticPointerCast<Tracked const>(owned)->value == 1);
+}
+
+TEST_CASE("load store exchange","[AtomicSharedPtr]") {
+    AtomicSharedPtr<Tracked> ap;
+    REQUIRE(ap.load().get() == nullptr);
+    ap.store(makeShared<Tracked>(1));
+    REQUIRE(ap.load()->value == 1);
+    SharedPtr<Tracked> old = ap.exchange(SharedPtr<Tracked>(new Tracked(2)));
+    REQUIRE(old->value == 1);
+    REQUIRE(ap.load()->value == 2);
+
+    SharedPtr<Tracked> expected = old;
+    REQUIRE_FALSE(ap.compare_exchange_strong(expected, makeShared<Tracked>(3)));
+    REQUIRE(expected->value == 2);
+    REQUIRE(ap.compare_exchange_strong(expected, makeShared<Tracked>(3)));
+    REQUIRE(ap.load()->value == 3);
+    ap.store(nullptr);
+    old.reset();
+    expected.reset();
+    REQUIRE(Tracked::alive == 0);
+}
+
+TEST_CASE("concurrent readers and writers","[AtomicSharedPtr]") {
+    struct Config {
+        long version;
+        long check;
+        std::atomic<int> *alive;
+        Config(long v,std::atomic<int> *a):version(v),check(-v),alive(a) { alive->fetch_add(1); }
+        ~Config() { alive->fetch_sub(1); }
+    };
+    std::atomic<int> alive{0};
+    {
+        AtomicSharedPtr<Config> ap(makeShared<Config>(0,&alive));
+        std::atomic<bool> stop{false};
+        std::atomic<long> bad{0};
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t) {
+            threads.emplace_back([&] {
+                while(!stop.load()) {
+                    SharedPtr<Config> cfg = ap.load();
+                    if(cfg->version != -cfg->check) bad.fetch_add(1);
+                }
+            });
+        }
+        threads.emplace_back([&] {
+            for(long v = 1; v <= 2000; ++v) {
+                ap.store(makeShared<Config>(v,&alive));
+            }
+        });
+        threads.emplace_back([&] {
+            // 用 CAS 做自增，检验失败时 expected 会被刷新
+            for(int i = 0; i < 500; ++i) {
+                SharedPtr<Config> cur = ap.load();
+                while(!ap.compare_exchange_weak(cur,makeShared<Config>(cur->version + 1,&alive))) {
+                }
+            }
+        });
+        threads[5].join();
+        threads[4].join();
+        stop.store(true);
+        for(int t = 0; t < 4; ++t) threads[t].join();
+        REQUIRE(bad.load() == 0);
+        REQUIRE(alive.load() == 1);
+    }
+    REQUIRE(alive.load() == 0);
+}
+
+template<class T>
+struct CountingAllocator {
+    using value_type = T;
+    int *allocs;
+    int *frees;
+    CountingAllocator(int *a,int *f):allocs(a),frees(f) {}
+    template<class U>
+    CountingAllocator(CountingAllocator<U> const &that):allocs(that.allocs),frees(that.frees) {}
+    T *allocate(std::size_t n) {
+        ++*allocs;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p,std::size_t n) {
+        ++*frees;
+        std::allocator<T>().deallocate(p,n);
+    }
+};
+
+TEST_CASE("allocateShared","[SharedPtr]") {
+    int allocs = 0,frees = 0;
+    WeakPtr<Tracked> wp;
+    {
+        auto sp = allocateShared<Tracked>(CountingAllocator<Tracked>(&allocs,&frees),9);
+        REQUIRE(sp->value == 9);
+        REQUIRE(allocs == 1); // 控制块和对象一次分配
+        wp = sp;
+    }
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(frees == 0);      // WeakPtr 还在，内存不能还
+    wp.reset();
+    REQUIRE(frees == 1);
+
+    auto st = allocateShared<Student>(ThreadLocalPoolAllocator<Student>(),"wxk",23);
+    REQUIRE(st->shared_from_this().get() == st.get());
+    void *first = st.get();
+    st.reset();
+    // 同一线程上立即复用刚归还的块
+    auto again = allocateShared<Student>(ThreadLocalPoolAllocator<Student>(),"wxk",24);
+    REQUIRE(static_cast<void *>(again.get()) == first);
+}
+
+TEST_CASE("array makeShared","[SharedPtr]") {
+    auto buf = makeShared<int[]>(16);
+    for(int i = 0; i < 16; ++i) {
+        REQUIRE(buf[i] == 0); // 值初始化
+        buf[i] = i * i;
+    }
+    SharedPtr<int const[]> view = buf;
+    REQUIRE(view[15] == 225);
+    REQUIRE(buf.use_count() == 2);
+
+    WeakPtr<Tracked> wp;
+    {
+        auto objs = makeShared<Tracked[]>(3);
+        REQUIRE(Tracked::alive == 3);
+        objs[2].value = 7;
+        SharedPtr<Tracked> last(objs,&objs[2]);
+        objs.reset();
+        REQUIRE(Tracked::alive == 3);
+        REQUIRE(last->value == 7);
+        wp = last;
+    }
+    REQUIRE(Tracked::alive == 0);
+    REQUIRE(wp.expired());
+
+    auto raw = makeSharedForOverwrite<double[]>(4);
+    raw[3] = 1.5;
+    REQUIRE(raw[3] == 1.5);
+    REQUIRE(makeShared<Tracked[]>(0).get() != nullptr);
+    SharedPtr<Tracked[]> owned(new Tracked[2]);
+    REQUIRE(Tracked::alive == 2);
+    owned.reset();
+    REQUIRE(Tracked::alive == 0);
+}
+
+struct GraphNode : IntrusiveRefCounted<GraphNode> {
+    static inline int alive = 0;
+    int id;
+    IntrusivePtr<GraphNode> next;
+    explicit GraphNode(int i):id(i) { ++alive; }
+    ~GraphNode() { --alive; }
+};
+struct LocalGraphNode : IntrusiveRefCounted<LocalGraphNode,SpNonAtomicPolicy> {
+    int id = 0;
+};
+
+TEST_CASE("intrusive pointer","[IntrusivePtr]") {
+    static_assert(sizeof(IntrusivePtr<GraphNode>) == sizeof(void *));
+    {
+        auto head = makeIntrusive<GraphNode>(1);
+        head->next = makeIntrusive<GraphNode>(2);
+        head->next->next = makeIntrusive<GraphNode>(3);
+        REQUIRE(GraphNode::alive == 3);
+        REQUIRE(head.use_count() == 1);
+
+        IntrusivePtr<GraphNode> second = head->next;
+        REQUIRE(second.use_count() == 2);
+        // 从裸指针重新得到 IntrusivePtr，计数在对象里
+        IntrusivePtr<GraphNode> again(second.get());
+        REQUIRE(second.use_count() == 3);
+        head = head->next; // 旧的 head 被释放，赋值期间 second 不能消失
+        REQUIRE(GraphNode::alive == 2);
+        REQUIRE(head->id == 2);
+
+        GraphNode *raw = again.detach();
+        IntrusivePtr<GraphNode> adopted(raw,false);
+        REQUIRE(adopted.use_count() == 3);
+    }
+    REQUIRE(GraphNode::alive == 0);
+
+    auto local = makeIntrusive<LocalGraphNode>();
+    IntrusivePtr<LocalGraphNode> copy = local;
+    REQUIRE(local.use_count() == 2);
+}
+
+TEST_CASE("intrusive and shared interop","[IntrusivePtr]") {
+    SharedPtr<GraphNode> shared;
+    {
+        auto node = makeIntrusive<GraphNode>(5);
+        shared = node.toShared();
+        REQUIRE(node.use_count() == 2);
+        SharedPtr<GraphNode> copy = shared;
+        REQUIRE(node.use_count() == 2); // 复制 SharedPtr 只动控制块的计数
+    }
+    REQUIRE(GraphNode::alive == 1);
+    IntrusivePtr<GraphNode> back = toIntrusive(shared);
+    REQUIRE(back.use_count() == 2);
+    shared.reset();
+    REQUIRE(GraphNode::alive == 1);
+    REQUIRE(back->id == 5);
+    back.reset();
+    REQUIRE(GraphNode::alive == 0);
+
+    // 来自 makeShared 的对象归控制块所有，不能转成 IntrusivePtr
+    auto owned = makeShared<GraphNode>(6);
+    REQUIRE(toIntrusive(owned) == nullptr);
+    REQUIRE(owned->use_count() == 0);
+    REQUIRE(toIntrusive(SharedPtr<GraphNode>(new GraphNode(7))) == nullptr);
+    REQUIRE(toIntrusive(SharedPtr<GraphNode>()) == nullptr);
+    owned.reset();
+    REQUIRE(GraphNode::alive == 0);
+}
+
+TEST_CASE("intrusive concurrent copy","[IntrusivePtr]") {
+    auto node = makeIntrusive<GraphNode>(0);
+    std::atomic<int> bad{0};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([node,&bad] {
+            for(int i = 0; i < 100000; ++i) {
+                IntrusivePtr<GraphNode> copy = node;
+                if(copy->id != 0) ++bad;
+            }
+        });
+    }
+    for(auto &th: threads) th.join();
+    REQUIRE(bad == 0);
+    REQUIRE(node.use_count() == 1);
+    node.reset();
+    REQUIRE(GraphNode::alive == 0);
+}
+
+struct ReleasedOn {
+    static inline std::atomic<int> alive{0};
+    static inline std::atomic<int> foreign{0}; // 在创建者以外的线程析构的个数
+    std::thread::id owner = std::this_thread::get_id();
+    SharedPtr<ReleasedOn> child;
+    ReleasedOn() { ++alive; }
+    ~ReleasedOn() {
+        --alive;
+        if(std::this_thread::get_id() != owner) ++foreign;
+    }
+};
+
+TEST_CASE("deferred release at a safe point","[SharedPtr]") {
+    {
+        SpDeferredReleaseScope scope;
+        std::vector<SharedPtr<ReleasedOn> > objs;
+        for(int i = 0; i < 100; ++i) {
+            objs.push_back(makeShared<ReleasedOn>());
+            objs.back()->child = makeShared<ReleasedOn>();
+        }
+        WeakPtr<ReleasedOn> wp = objs.front();
+        objs.clear();
+        REQUIRE(ReleasedOn::alive == 200);
+        REQUIRE(scope.pending() == 100);
+        REQUIRE(wp.expired());
+        spDrainRetired(); // 子对象在释放父对象时归零，同样被延迟，直到全部释放完
+        REQUIRE(ReleasedOn::alive == 0);
+        REQUIRE(scope.pending() == 0);
+
+        // 非原子计数的块不会被延迟
+        auto local = makeShared<Tracked,SpNonAtomicPolicy>(1);
+        local.reset();
+        REQUIRE(Tracked::alive == 0);
+        objs.push_back(makeShared<ReleasedOn>());
+        objs.clear();
+    }
+    REQUIRE(ReleasedOn::alive == 0); // scope 结束时释放剩下的
+    auto outside = makeShared<ReleasedOn>();
+    outside.reset();
+    REQUIRE(ReleasedOn::alive == 0);
+}
+
+TEST_CASE("deferred release on a background thread","[SharedPtr]") {
+    ReleasedOn::foreign = 0;
+    SpBackgroundReclaimer reclaimer;
+    {
+        SpDeferredReleaseScope scope(reclaimer,64);
+        std::vector<SharedPtr<ReleasedOn> > objs;
+        for(int i = 0; i < 1000; ++i) {
+            objs.push_back(makeShared<ReleasedOn>());
+            if(i % 2 == 0) {
+                objs.back()->child = makeShared<ReleasedOn>();
+            }
+        }
+        objs.clear();
+        REQUIRE(scope.pending() < 64);
+    }
+    reclaimer.flush();
+    REQUIRE(ReleasedOn::alive == 0);
+    REQUIRE(ReleasedOn::foreign == 1500); // 子对象在后台线程上归零，也在后台线程上释放
+}
+
+TEST_CASE("object pool","[ObjectPool]") {
+    ObjectPool<Tracked> pool;
+    void *first;
+    {
+        auto a = pool.make(1);
+        first = a.get();
+        auto b = pool.make(2);
+        REQUIRE(Tracked::alive == 2);
+    }
+    REQUIRE(Tracked::alive == 0);
+    auto c = pool.make(3);
+    REQUIRE(static_cast<void *>(c.get()) == first);
+    pool.flushLocal();
+    ObjectPoolStats stats = pool.stats();
+    REQUIRE(stats.misses == 1);     // 第一次分配从共享链表取了一批
+    REQUIRE(stats.hits == 2);
+    REQUIRE(stats.highWater == ObjectPoolCore::kBatch);
+
+    // SharedPtr 的控制块和对象一起从池子里分配
+    WeakPtr<Tracked> wp;
+    void *block;
+    {
+        SharedPtr<Tracked> sp = pool.makeShared(4);
+        block = sp.get();
+        wp = sp;
+        REQUIRE(sp->value == 4);
+    }
+    REQUIRE(Tracked::alive == 1);
+    wp.reset();
+    REQUIRE(static_cast<void *>(pool.makeShared(5).get()) == block);
+}
+
+TEST_CASE("object pool across threads","[ObjectPool]") {
+    ObjectPool<ReleasedOn> pool;
+    constexpr int kThreads = 4;
+    constexpr int kRounds = 20000;
+    std::vector<std::thread> threads;
+    std::vector<ObjectPool<ReleasedOn>::Handle> handoff[kThreads];
+    for(int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&pool,&handoff,t] {
+            std::vector<ObjectPool<ReleasedOn>::Handle> held;
+            for(int i = 0; i < kRounds; ++i) {
+                held.push_back(pool.make());
+                if(held.size() > 100) {
+                    held.erase(held.begin(),held.begin() + 50);
+                }
+            }
+            handoff[t] = std::move(held);   // 剩下的交给主线程释放
+        });
+    }
+    for(auto &th: threads) th.join();
+    for(auto &held: handoff) held.clear();
+    REQUIRE(ReleasedOn::alive == 0);
+    pool.flushLocal();
+    ObjectPoolStats stats = pool.stats();
+    REQUIRE(stats.hits + stats.misses == std::uint64_t(kThreads) * kRounds);
+    REQUIRE(stats.highWater < std::uint64_t(kThreads) * kRounds / 10);
+}
+
 /*
 int main() {
 
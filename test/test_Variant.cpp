@@ -3,7 +3,11 @@
 //
 #include <catch2/catch_test_macros.hpp>
 #include <Variant.hpp>
+#include <VariantSerialize.hpp>
+#include <VariantVector.hpp>
 #include <iostream>
+#include <string>
+#include <vector>
 
 TEST_CASE("ctor","[variant]")
 {
@@ -96,3 +100,298 @@ TEST_CASE("inplace ctor","[variant]") {
     Variant<int,Foo> v(inPlaceIndex<1>,Foo(3));
     REQUIRE(v.get<Foo>().i==(3));
 }
+
+template<int I>
+struct Tag {
+    int value = I;
+};
+
+TEST_CASE("visit dispatch","[variant]") {
+    // 不超过 variant_switch_max 个候选项时走 switch
+    Variant<int,float,char> small(inPlaceIndex<2>,'x');
+    REQUIRE(small.visit([](auto &arg) { return sizeof(arg); }) == 1);
+    small.visit([](auto &arg) { arg += 1; });
+    REQUIRE(small.get<char>() == 'y');
+
+    // 超过时走函数指针表
+    using Big = Variant<Tag<0>,Tag<1>,Tag<2>,Tag<3>,Tag<4>,Tag<5>,Tag<6>,Tag<7>,Tag<8>,
+                        Tag<9>,Tag<10>,Tag<11>,Tag<12>,Tag<13>,Tag<14>,Tag<15>,Tag<16>,Tag<17>>;
+    Big first(inPlaceIndex<0>);
+    Big last(inPlaceIndex<17>);
+    REQUIRE(first.visit([](auto &arg) { return arg.value; }) == 0);
+    REQUIRE(last.visit([](auto &arg) { return arg.value; }) == 17);
+}
+
+TEST_CASE("multi visit","[variant]") {
+    using Num = Variant<int,double>;
+    auto add = [](auto a, auto b) -> double { return a + b; };
+    REQUIRE(Visit(add,Num(1),Num(2.5)) == 3.5);
+    Num const x(4);
+    Num y(0.5);
+    REQUIRE(Visit(add,x,y) == 4.5);
+
+    // 每一种组合都分派到正确的重载
+    struct Which {
+        int operator()(int,int) const { return 0; }
+        int operator()(int,double) const { return 1; }
+        int operator()(double,int) const { return 2; }
+        int operator()(double,double) const { return 3; }
+    };
+    REQUIRE(Visit(Which{},Num(1),Num(1)) == 0);
+    REQUIRE(Visit(Which{},Num(1),Num(1.0)) == 1);
+    REQUIRE(Visit(Which{},Num(1.0),Num(1)) == 2);
+    REQUIRE(Visit(Which{},Num(1.0),Num(1.0)) == 3);
+
+    // 三个 Variant，共 2*3*3 = 18 种组合，超过 switch 的上限
+    using Three = Variant<int,char,long>;
+    auto sum = [](auto a, auto b, auto c) { return long(a) + long(b) + long(c); };
+    REQUIRE(Visit(sum,Num(1),Three(long(2)),Three(char(3))) == 6);
+
+    // 右值的候选项以右值传入
+    struct Kind {
+        int operator()(int &) const { return 0; }
+        int operator()(int const &) const { return 1; }
+        int operator()(int &&) const { return 2; }
+        int operator()(double) const { return 3; }
+    };
+    Num lv(1);
+    REQUIRE(Visit(Kind{},lv) == 0);
+    REQUIRE(Visit(Kind{},x) == 1);
+    REQUIRE(Visit(Kind{},std::move(lv)) == 2);
+    REQUIRE(x.visit([](auto const &arg) { return int(arg); }) == 4);
+}
+
+struct Counted {
+    static inline int copies = 0;
+    static inline int moves = 0;
+    static inline int destroyed = 0;
+    static inline int assigns = 0;
+    int i = 0;
+    Counted(int i) : i(i) {}
+    Counted(Counted const &that) : i(that.i) { ++copies; }
+    Counted(Counted &&that) noexcept : i(that.i) { ++moves; }
+    Counted &operator=(Counted const &that) { i = that.i; ++assigns; return *this; }
+    Counted &operator=(Counted &&that) noexcept { i = that.i; ++assigns; return *this; }
+    ~Counted() { ++destroyed; }
+};
+
+TEST_CASE("trivial special members","[variant]") {
+    using Plain = Variant<int,double,unsigned long>;
+    static_assert(std::is_trivially_copyable_v<Plain>);
+    static_assert(std::is_trivially_destructible_v<Plain>);
+    static_assert(!std::is_trivially_copyable_v<Variant<int,Counted> >);
+    static_assert(!std::is_trivially_destructible_v<Variant<int,Counted> >);
+
+    std::vector<Plain> plain;
+    for (int i = 0; i < 100; ++i) {
+        plain.push_back(Plain(double(i)));
+    }
+    REQUIRE(plain[99].get<double>() == 99.0);
+    Plain copy = plain[42];
+    REQUIRE(copy.get<double>() == 42.0);
+
+    // 非平凡的候选项仍然调用它自己的复制、移动和析构
+    Counted::copies = Counted::moves = Counted::destroyed = 0;
+    {
+        Variant<int,Counted> a(Counted(7));
+        Variant<int,Counted> b(a);
+        Variant<int,Counted> c(std::move(b));
+        REQUIRE(c.get<Counted>().i == 7);
+        REQUIRE(Counted::copies == 1);
+        REQUIRE(Counted::moves == 2);
+    }
+    REQUIRE(Counted::destroyed == 4);
+}
+
+TEST_CASE("emplace and assignment","[variant]") {
+    Variant<int,Counted> v;
+    REQUIRE(v.index() == 0);
+    REQUIRE(v.get<int>() == 0);
+
+    Counted::copies = Counted::moves = Counted::destroyed = Counted::assigns = 0;
+    REQUIRE(v.emplace<Counted>(5).i == 5);          // 原地构造，没有临时对象
+    REQUIRE(Counted::moves == 0);
+    REQUIRE(Counted::destroyed == 0);
+
+    Variant<int,Counted> other(Counted(6));
+    Counted::moves = Counted::destroyed = 0;
+    v = other;                                      // 同一个候选项: 直接赋值
+    REQUIRE(v.get<Counted>().i == 6);
+    REQUIRE(Counted::assigns == 1);
+    REQUIRE(Counted::copies == 0);
+    v = std::move(other);
+    REQUIRE(Counted::assigns == 2);
+    REQUIRE(Counted::moves == 0);
+
+    Variant<int,Counted> number(3);
+    v = number;                                     // 不同的候选项: 先析构再构造
+    REQUIRE(v.get<int>() == 3);
+    REQUIRE(Counted::destroyed == 1);
+    v = std::move(other);
+    REQUIRE(v.get<Counted>().i == 6);
+    REQUIRE(Counted::moves == 1);
+    v.emplace<0>(9);
+    REQUIRE(v.get<int>() == 9);
+    REQUIRE(Counted::destroyed == 2);
+    static_assert([] {
+        Variant<int,double> x;
+        x.emplace<1>(2.5);
+        return x.get<double>();
+    }() == 2.5);
+}
+
+struct ThrowOnInt {
+    ThrowOnInt(int) { throw 1; }
+};
+
+TEST_CASE("emplace that throws","[variant]") {
+    // 旧值已经析构，退回到值初始化的第 0 个候选项
+    Variant<std::string,ThrowOnInt> v(std::string("lost"));
+    REQUIRE_THROWS(v.emplace<1>(1));
+    REQUIRE(v.index() == 0);
+    REQUIRE(v.get<std::string>().empty());
+}
+
+TEST_CASE("compact index","[variant]") {
+    static_assert(sizeof(Variant<int,float>) == 8);
+    static_assert(sizeof(Variant<char,bool>) == 2);
+    static_assert(sizeof(Variant<double,long>) == 16);
+    static_assert(std::is_same_v<variant_index_t<2>,unsigned char>);
+    static_assert(std::is_same_v<variant_index_t<300>,unsigned short>);
+    Variant<char,bool> v(true);
+    REQUIRE(v.index() == 1);
+    REQUIRE(v.get<bool>());
+}
+
+// 编译期构造的查找表
+struct Opcode {
+    int code;
+    constexpr Opcode(int c) : code(c) {}
+    constexpr Opcode(Opcode const &that) : code(that.code + 100) {} // 非平凡但仍是字面类型
+    constexpr explicit operator double() const { return code; }
+};
+
+constexpr Variant<int, double, Opcode> kTable[] = {
+    Variant<int, double, Opcode>(1),
+    Variant<int, double, Opcode>(2.5),
+    Variant<int, double, Opcode>(inPlaceIndex<2>, 7),
+};
+
+constexpr double copy_and_sum() {
+    double sum = 0;
+    for (auto const &entry: kTable) {
+        Variant<int, double, Opcode> copy(entry);
+        sum += copy.visit([](auto const &value) { return double(value); });
+    }
+    return sum;
+}
+
+TEST_CASE("constexpr variant","[variant]") {
+    static_assert(kTable[0].index() == 0);
+    static_assert(kTable[1].holds_alternative<double>());
+    static_assert(kTable[1].get<double>() == 2.5);
+    static_assert(kTable[2].get<2>().code == 7);
+    static_assert(kTable[0].get_if<double>() == nullptr);
+    static_assert(*kTable[0].get_if<int>() == 1);
+    static_assert(Visit([](auto a, auto b) { return double(a) + double(b); }, kTable[0], kTable[1]) == 3.5);
+    static_assert(copy_and_sum() == 1 + 2.5 + 107);
+    REQUIRE(kTable[2].get<Opcode>().code == 7);
+    REQUIRE(copy_and_sum() == 110.5);
+}
+
+TEST_CASE("variant vector","[VariantVector]") {
+    VariantVector<int,double,Counted> vec;
+    vec.push_back(1);
+    vec.push_back(2.5);
+    vec.emplace_back<2>(3);
+    vec.push_back(Variant<int,double,Counted>(4));
+    vec.push_back(Counted(5));
+    REQUIRE(vec.size() == 5);
+    REQUIRE(vec.column<int>().size() == 2);
+    REQUIRE(vec.column<1>().size() == 1);
+    REQUIRE(vec.column<Counted>().size() == 2);
+
+    // 按插入顺序访问
+    std::vector<double> ordered;
+    for (auto ref: vec) {
+        ordered.push_back(ref.visit([](auto const &value) -> double {
+            if constexpr (std::is_same_v<std::decay_t<decltype(value)>,Counted>) {
+                return value.i;
+            } else {
+                return value;
+            }
+        }));
+    }
+    REQUIRE(ordered == std::vector<double>{1, 2.5, 3, 4, 5});
+    REQUIRE(vec[2].holds_alternative<Counted>());
+    REQUIRE(vec[2].get<Counted>().i == 3);
+    REQUIRE_THROWS_AS(vec[2].get<int>(),BadVariantAccess);
+    vec[0].get<int>() = 10;
+    Variant<int,double,Counted> loaded = vec[0].load();
+    REQUIRE(loaded.get<int>() == 10);
+
+    // 逐列访问
+    int ints = 0;
+    vec.visit_all([&](auto &value) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>,int>) {
+            ints += value;
+        }
+    });
+    REQUIRE(ints == 14);
+
+    vec.pop_back();
+    REQUIRE(vec.size() == 4);
+    REQUIRE(vec.column<Counted>().size() == 1);
+    vec.clear();
+    REQUIRE(vec.empty());
+}
+
+struct Point {
+    float x, y;
+};
+
+TEST_CASE("variant serialization","[VariantSerialize]") {
+    using Msg = Variant<char, double, Point, std::uint16_t>;
+    std::vector<Msg> msgs = {Msg('a'), Msg(1.5), Msg(Point{2, 3}), Msg(std::uint16_t(7)), Msg('b')};
+
+    std::vector<std::byte> bytes;
+    encodeVariants(std::span(msgs), bytes);
+    // 'a' 2 字节 | 1.5 补到 8 再 8 字节 | Point 补到 4 再 8 字节 | uint16 补到 2 再 2 字节 | 'b' 2 字节
+    REQUIRE(bytes.size() == 2 + 14 + 12 + 4 + 2);
+
+    // 视图直接指向缓冲区里的字节
+    VariantView<char, double, Point, std::uint16_t> view(bytes, 2);
+    REQUIRE(view.index() == 1);
+    REQUIRE(view.get<double>() == 1.5);
+    REQUIRE(reinterpret_cast<std::byte const *>(&view.get<double>()) == bytes.data() + 8);
+    REQUIRE(view.get_if<char>() == nullptr);
+    REQUIRE_THROWS_AS(view.get<Point>(), BadVariantAccess);
+    VariantView<char, double, Point, std::uint16_t> point(bytes, view.next());
+    REQUIRE(point.visit([](auto const &v) -> double {
+        if constexpr (std::is_same_v<std::decay_t<decltype(v)>, Point>) {
+            return v.x + v.y;
+        } else {
+            return 0;
+        }
+    }) == 5);
+
+    std::vector<Msg> decoded(msgs.size(), Msg('z'));
+    REQUIRE(decodeVariants(bytes, std::span(decoded)) == msgs.size());
+    REQUIRE(decoded[0].get<char>() == 'a');
+    REQUIRE(decoded[2].get<Point>().y == 3);
+    REQUIRE(decoded[3].get<std::uint16_t>() == 7);
+    REQUIRE(decoded[4].get<char>() == 'b');
+
+    // 单条追加和整批编码结果相同
+    std::vector<std::byte> one_by_one;
+    for (Msg const &m: msgs) {
+        encodeVariant(m, one_by_one);
+    }
+    REQUIRE(one_by_one == bytes);
+
+    // 坏的下标和截断的记录
+    bytes[0] = std::byte{9};
+    REQUIRE_THROWS_AS((VariantView<char, double, Point, std::uint16_t>(bytes)), BadVariantEncoding);
+    REQUIRE_THROWS_AS((VariantView<char, double, Point, std::uint16_t>(std::span(bytes).first(10), 2)),
+                      BadVariantEncoding);
+}